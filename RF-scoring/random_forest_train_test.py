@@ -50,7 +50,7 @@ def train(args):
     merged_data = read_and_prepare_data(input_files)
 
     # Prepare the training data
-    X_train = merged_data.drop(columns=['circRNA_id', 'label'])
+    X_train = merged_data.drop(columns=['circRNA_id', 'label', 'sample_rate'], errors='ignore')
     y_train = merged_data['label']
     print(y_train.value_counts())
 
@@ -75,7 +75,7 @@ def test(args):
     for file in input_files:
         test_data = pd.read_csv(file)
         circRNA_ids = test_data['circRNA_id']
-        X_test = test_data.drop(columns=['circRNA_id'])
+        X_test = test_data.drop(columns=['circRNA_id', 'sample_rate'], errors='ignore')
 
         # Get the probability predictions for label "1"
         probabilities = model.predict_proba(X_test)[:, 1]  
@@ -0,0 +1,152 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cassert>
+
+#include "circ_key.h"
+#include "util.h"
+
+static inline uint64_t mix_key(uint64_t h, uint64_t x)
+{
+	h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	return h ^ (h >> 27);
+}
+
+static inline int count_digits(int32_t x)
+{
+	int d = 1;
+	for(; x >= 10; x /= 10) d++;
+	return d;
+}
+
+// compare x and y as the tokens "x|" and "y|" in string order
+static int compare_token(int32_t x, int32_t y)
+{
+	if(x == y) return 0;
+	if(x < 0 || y < 0)
+	{
+		string a = tostring(x) + "|";
+		string b = tostring(y) + "|";
+		return (a < b) ? -1 : 1;
+	}
+
+	int dx = count_digits(x);
+	int dy = count_digits(y);
+	// compare the leading digits the two have in common
+	int32_t a = x, b = y;
+	for(int i = dy; i < dx; i++) a /= 10;
+	for(int i = dx; i < dy; i++) b /= 10;
+	if(a < b) return -1;
+	if(a > b) return 1;
+
+	// the shorter one is a digit prefix of the other and is
+	// followed by '|', which sorts after every digit
+	return (dx < dy) ? 1 : -1;
+}
+
+// compare x and y as the strings "x:" and "y:"
+static int compare_chrm(const string &x, const string &y)
+{
+	size_t n = (x.size() < y.size()) ? x.size() : y.size();
+	for(size_t i = 0; i < n; i++)
+	{
+		if(x[i] == y[i]) continue;
+		return ((unsigned char)x[i] < (unsigned char)y[i]) ? -1 : 1;
+	}
+	if(x.size() == y.size()) return 0;
+	if(x.size() < y.size()) return ((unsigned char)':' < (unsigned char)y[n]) ? -1 : 1;
+	return ((unsigned char)x[n] < (unsigned char)':') ? -1 : 1;
+}
+
+circ_key::circ_key()
+{
+	hash = 0;
+	chain_hash = 0;
+}
+
+int circ_key::set(const string &chrm, int32_t start, int32_t end, const vector<region_span> &exons)
+{
+	this->chrm = chrm;
+	v.resize(2 + 2 * exons.size());
+	v[0] = start;
+	v[1] = end;
+	for(int i = 0; i < exons.size(); i++)
+	{
+		v[2 + 2 * i + 0] = exons[i].lpos;
+		v[2 + 2 * i + 1] = exons[i].rpos;
+	}
+
+	chain_hash = 0;
+	for(int i = 3; i < (int)v.size() - 1; i++) chain_hash = mix_key(chain_hash, (uint32_t)v[i]);
+
+	hash = mix_key(bytes_hash(chrm.c_str(), chrm.size()), v.size());
+	for(int i = 0; i < v.size(); i++) hash = mix_key(hash, (uint32_t)v[i]);
+	return 0;
+}
+
+string circ_key::str() const
+{
+	string s = chrm + ":";
+	char buf[16];
+	for(int i = 0; i < v.size(); i++)
+	{
+		snprintf(buf, sizeof(buf), "%d|", v[i]);
+		s.append(buf);
+	}
+	return s;
+}
+
+bool circ_key::same_chain(const circ_key &x) const
+{
+	// the chain is empty for circRNAs with at most one exon
+	if(chain_hash != x.chain_hash) return false;
+	int n = (v.size() > 4) ? v.size() - 4 : 0;
+	int m = (x.v.size() > 4) ? x.v.size() - 4 : 0;
+	if(n != m) return false;
+	for(int i = 3; i < n + 3; i++)
+	{
+		if(v[i] != x.v[i]) return false;
+	}
+	return true;
+}
+
+int32_t circ_key::start() const
+{
+	assert(v.size() >= 2);
+	return v[0];
+}
+
+int32_t circ_key::end() const
+{
+	assert(v.size() >= 2);
+	return v[1];
+}
+
+bool circ_key::operator<(const circ_key &x) const
+{
+	int c = compare_chrm(chrm, x.chrm);
+	if(c != 0) return c < 0;
+
+	size_t n = (v.size() < x.v.size()) ? v.size() : x.v.size();
+	for(size_t i = 0; i < n; i++)
+	{
+		c = compare_token(v[i], x.v[i]);
+		if(c != 0) return c < 0;
+	}
+	return v.size() < x.v.size();
+}
+
+bool circ_key::operator==(const circ_key &x) const
+{
+	if(hash != x.hash) return false;
+	return chrm == x.chrm && v == x.v;
+}
+
+bool circ_key::operator!=(const circ_key &x) const
+{
+	return !(*this == x);
+}
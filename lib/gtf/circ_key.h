@@ -0,0 +1,42 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __GTF_CIRC_KEY_H__
+#define __GTF_CIRC_KEY_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../../src/region.h"
+
+using namespace std;
+
+// binary identity of a circRNA: chromosome, back-splice boundaries and the
+// boundaries of its merged exons; ordered exactly as the rendered string
+// "chrm:start|end|l1|r1|...|ln|rn|" so that maps keyed by it iterate the same
+class circ_key
+{
+public:
+	circ_key();
+
+public:
+	string chrm;				// chromosome name
+	vector<int32_t> v;			// start, end, then lpos/rpos of each merged exon
+	uint64_t hash;				// hash over chrm and v
+	uint64_t chain_hash;		// hash over the intron chain v[3..n-2]
+
+public:
+	int set(const string &chrm, int32_t start, int32_t end, const vector<region_span> &exons);
+	string str() const;
+	bool same_chain(const circ_key &x) const;
+	int32_t start() const;
+	int32_t end() const;
+
+	bool operator<(const circ_key &x) const;
+	bool operator==(const circ_key &x) const;
+	bool operator!=(const circ_key &x) const;
+};
+
+#endif
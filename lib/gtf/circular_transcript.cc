@@ -14,12 +14,10 @@ See LICENSE for licensing.
 
 circular_transcript::circular_transcript()
 {
-    circRNA_id = "";
     seqname = "";
     source = "";
     feature = "";
     gene_id = "";
-    transcript_id = "";
     gene_type = "";
     transcript_type = "";
 	start = 0;
@@ -50,6 +48,8 @@ circular_transcript::circular_transcript()
 	path_count_4 = 0;
     candidate_path_count = 0;
     fake_count = 0;
+    sample_rate = 1;
+    umi_reads = 0;
 
     junc_reads = 0;
     non_junc_reads = 0;
@@ -58,9 +58,8 @@ circular_transcript::circular_transcript()
     merged_regions.clear();
 }
 
-circular_transcript::circular_transcript(string circRNA_ID, string chrm_id, int32_t start, int32_t end, vector<int> circ_path)
+circular_transcript::circular_transcript(string chrm_id, int32_t start, int32_t end, vector<int> circ_path)
 {
-    circRNA_id = circRNA_ID;
     seqname = chrm_id;
     start = start;
     end = end;
@@ -68,9 +67,8 @@ circular_transcript::circular_transcript(string circRNA_ID, string chrm_id, int3
     this->circ_path.insert(this->circ_path.begin(), circ_path.begin(),circ_path.end());
 }
 
-circular_transcript::circular_transcript(string circRNA_ID, string chrm_id, int32_t start, int32_t end, vector<int> circ_path, int32_t junc_reads, int32_t non_junc_reads)
+circular_transcript::circular_transcript(string chrm_id, int32_t start, int32_t end, vector<int> circ_path, int32_t junc_reads, int32_t non_junc_reads)
 {
-    circRNA_id = circRNA_ID;
     seqname = chrm_id;
     start = start;
     end = end;
@@ -85,6 +83,8 @@ int circular_transcript::write(ostream &fout, double cov2, int count) const
 {
     fout.precision(4);
 	fout<<fixed;
+
+	string id = key.str(); //circRNA id, also used as transcript_id
     
     //fout<<"chrm_id="<<chrm_id.c_str()<<"\t";
     fout<<seqname.c_str()<<"\t";
@@ -96,8 +96,11 @@ int circular_transcript::write(ostream &fout, double cov2, int count) const
 	fout<<strand<<"\t";							// strand
 	fout<<".\t";								            // frame
 	fout<<"gene_id \""<<gene_id.c_str()<<"\"; ";
-	fout<<"transcript_id \""<<transcript_id.c_str()<<"\"; ";
-    fout<<"cov \""<<coverage<<"\";"<<endl;
+	fout<<"transcript_id \""<<id.c_str()<<"\"; ";
+    fout<<"cov \""<<coverage<<"\"; ";
+    fout<<"reads \""<<reads.size()<<"\";";
+    if(umi_reads >= 1) fout<<" umi_reads \""<<umi_reads<<"\";";
+    fout<<endl;
     
     /*fout<<"path vertices= ( ";
     for(int i=0;i<circ_path.size();i++)
@@ -161,7 +164,7 @@ int circular_transcript::write(ostream &fout, double cov2, int count) const
         fout<<strand<<"\t";							// strand
         fout<<".\t";								            // frame
         fout<<"gene_id \""<<gene_id.c_str()<<"\"; ";
-        fout<<"transcript_id \""<<transcript_id.c_str()<<"\"; ";
+        fout<<"transcript_id \""<<id.c_str()<<"\"; ";
         fout<<"exon \""<<++cnt<<"\"; "<<endl;
         //fout<<"coverage \""<<coverage<<"\";"<<endl;
     }
@@ -190,7 +193,7 @@ int circular_transcript::print(int id)
         printf("[%d, %d) ",merged_regions[i].lpos,merged_regions[i].rpos); 
     }
     printf("\n");*/
-    printf("circRNA_id:%s, chrm:%s, bundle_size:%lu, coverage:%d, fake_count:%d, supple_len:%d, candidate_path_count:%d, path_score:%lf, path_count_1:%d, path_count_2:%d, path_count_3:%d, path_count_4:%d, exon_count:%d, total_exon_len:%d, max_exon_len:%d, min_exon_len:%d, avg_exon_len:%lf\n",circRNA_id.c_str(), seqname.c_str(), bundle_size, coverage, fake_count, supple_len, candidate_path_count, path_score, path_count_1, path_count_2, path_count_3, path_count_4, exon_count, total_exon_length, max_exon_length, min_exon_length, avg_exon_length);
+    printf("circRNA_id:%s, chrm:%s, bundle_size:%lu, coverage:%d, fake_count:%d, supple_len:%d, candidate_path_count:%d, path_score:%lf, path_count_1:%d, path_count_2:%d, path_count_3:%d, path_count_4:%d, exon_count:%d, total_exon_len:%d, max_exon_len:%d, min_exon_len:%d, avg_exon_len:%lf\n",key.str().c_str(), seqname.c_str(), bundle_size, coverage, fake_count, supple_len, candidate_path_count, path_score, path_count_1, path_count_2, path_count_3, path_count_4, exon_count, total_exon_length, max_exon_length, min_exon_length, avg_exon_length);
     return 0;
 
 }
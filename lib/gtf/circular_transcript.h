@@ -12,6 +12,7 @@ See LICENSE for licensing.
 #include <vector>
 #include <set>
 #include "../../src/region.h"
+#include "circ_key.h"
 
 using namespace std;
 
@@ -21,19 +22,18 @@ class circular_transcript
 {
 public:
     circular_transcript();
-    circular_transcript(string circRNA_ID, string chrm_id, int32_t start, int32_t end, vector<int> circ_path);
-    circular_transcript(string circRNA_ID, string chrm_id, int32_t start, int32_t end, vector<int> circ_path, int32_t junc_reads, int32_t non_junc_reads);
+    circular_transcript(string chrm_id, int32_t start, int32_t end, vector<int> circ_path);
+    circular_transcript(string chrm_id, int32_t start, int32_t end, vector<int> circ_path, int32_t junc_reads, int32_t non_junc_reads);
 	int write(ostream &fout, double cov2 = -1, int count = -1) const;
     int print(int id);
     ~circular_transcript();
 public:
 
-	string circRNA_id;
+	circ_key key; //chrm, start, end and merged exon boundaries; rendered as the circRNA id on output
     string seqname; //chromosome id
 	string source;
 	string feature;
 	string gene_id; //is it needed for circRNA? this infor comes from splice graphs of each gene, difficult to extract for circRNA
-	string transcript_id;
 	string gene_type;
 	string transcript_type;
 	int32_t start;
@@ -65,10 +65,13 @@ public:
 	int path_count_4;
 	int candidate_path_count;
 	int fake_count;
+	double sample_rate; //fraction of non-chimeric reads kept in the bundle, 1 if not downsampled
+	int32_t umi_reads; //reads of the UMI molecules supporting this circRNA, 0 without UMI dedup
 
+    vector<int32_t> reads; //interned qname ids of supporting reads, one per hit; distinct after merging
     vector<int> circ_path;
-	vector<region> circ_path_regions;
-	vector<region> merged_regions;
+	vector<region_span> circ_path_regions;
+	vector<region_span> merged_regions;
     
     int32_t junc_reads;
     int32_t non_junc_reads;
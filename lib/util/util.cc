@@ -5,6 +5,7 @@ See LICENSE for licensing.
 */
 
 #include "util.h"
+#include <cstring>
 
 vector<int> get_random_permutation(int n)
 {
@@ -31,6 +32,29 @@ size_t string_hash(const std::string& str)
 	return (hash & 0x7FFFFFFF);
 }
 
+// 64-bit hash over raw bytes, 8 bytes per step; no allocation
+size_t bytes_hash(const char *s, size_t l)
+{
+	const uint64_t m = 0x9e3779b97f4a7c15ULL;
+	uint64_t h = 0x243f6a8885a308d3ULL ^ (l * m);
+	while(l >= 8)
+	{
+		uint64_t x;
+		memcpy(&x, s, 8);
+		h = (h ^ x) * m;
+		h ^= h >> 29;
+		s += 8;
+		l -= 8;
+	}
+	uint64_t x = 0;
+	for(size_t i = 0; i < l; i++) x |= ((uint64_t)(uint8_t)s[i]) << (8 * i);
+	h = (h ^ x) * m;
+	h ^= h >> 32;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 31;
+	return (size_t)h;
+}
+
 size_t vector_hash(const vector<int32_t> & vec)
 {
 	size_t seed = vec.size();
@@ -181,6 +181,7 @@ vector<K> get_keys(const map<K, V> &m)
 
 vector<int> get_random_permutation(int n);
 size_t string_hash(const std::string& str);
+size_t bytes_hash(const char *s, size_t l);
 size_t vector_hash(const vector<int32_t> &str);
 
 #endif
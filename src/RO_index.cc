@@ -0,0 +1,133 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "RO_index.h"
+#include "util.h"
+
+// derive a well-mixed 64-bit value from qhash for bloom probing
+static inline uint64_t mix_qhash(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+RO_chrm_index::RO_chrm_index()
+{
+	bloom_bits = 0;
+}
+
+int RO_chrm_index::build(int bits_per_read)
+{
+	// sort (qhash, qname) pairs and remove duplicates
+	vector< pair<size_t, string> > v(qhashes.size());
+	for(int i = 0; i < qhashes.size(); i++) v[i] = pair<size_t, string>(qhashes[i], qnames[i]);
+	sort(v.begin(), v.end());
+	v.erase(unique(v.begin(), v.end()), v.end());
+
+	qhashes.resize(v.size());
+	qnames.resize(v.size());
+	for(int i = 0; i < v.size(); i++)
+	{
+		qhashes[i] = v[i].first;
+		qnames[i] = v[i].second;
+	}
+
+	bloom.clear();
+	bloom_bits = 0;
+	if(bits_per_read <= 0 || qhashes.size() == 0) return 0;
+
+	bloom_bits = ((uint64_t)qhashes.size() * bits_per_read + 63) / 64 * 64;
+	bloom.assign(bloom_bits / 64, 0);
+	for(int i = 0; i < qhashes.size(); i++)
+	{
+		uint64_t h = mix_qhash(qhashes[i]);
+		uint64_t d = (h >> 32) | 1;
+		for(int k = 0; k < 3; k++)
+		{
+			uint64_t b = (h + k * d) % bloom_bits;
+			bloom[b >> 6] |= ((uint64_t)1 << (b & 63));
+		}
+	}
+	return 0;
+}
+
+bool RO_chrm_index::bloom_test(size_t qhash) const
+{
+	if(bloom_bits == 0) return true;
+	uint64_t h = mix_qhash(qhash);
+	uint64_t d = (h >> 32) | 1;
+	for(int k = 0; k < 3; k++)
+	{
+		uint64_t b = (h + k * d) % bloom_bits;
+		if((bloom[b >> 6] & ((uint64_t)1 << (b & 63))) == 0) return false;
+	}
+	return true;
+}
+
+bool RO_chrm_index::contains(size_t qhash, const string &qname) const
+{
+	if(qhashes.size() == 0) return false;
+	if(bloom_test(qhash) == false) return false;
+
+	vector<size_t>::const_iterator it = lower_bound(qhashes.begin(), qhashes.end(), qhash);
+	for(int k = it - qhashes.begin(); k < qhashes.size() && qhashes[k] == qhash; k++)
+	{
+		if(qnames[k] == qname) return true;
+	}
+	return false;
+}
+
+int RO_chrm_index::size() const
+{
+	return qhashes.size();
+}
+
+RO_index::RO_index()
+{
+	num_reads = 0;
+}
+
+int RO_index::add(const string &chrm, const string &qname)
+{
+	RO_chrm_index &ci = chrms[chrm];
+	ci.qhashes.push_back(bytes_hash(qname.c_str(), qname.size()));
+	ci.qnames.push_back(qname);
+	return 0;
+}
+
+int RO_index::build(int bits_per_read)
+{
+	num_reads = 0;
+	for(map<string, RO_chrm_index>::iterator it = chrms.begin(); it != chrms.end(); it++)
+	{
+		it->second.build(bits_per_read);
+		num_reads += it->second.size();
+	}
+	return 0;
+}
+
+const RO_chrm_index* RO_index::get(const string &chrm) const
+{
+	map<string, RO_chrm_index>::const_iterator it = chrms.find(chrm);
+	if(it == chrms.end()) return NULL;
+	return &(it->second);
+}
+
+bool RO_index::contains(const string &chrm, size_t qhash, const string &qname) const
+{
+	const RO_chrm_index *ci = get(chrm);
+	if(ci == NULL) return false;
+	return ci->contains(qhash, qname);
+}
+
+int RO_index::size() const
+{
+	return num_reads;
+}
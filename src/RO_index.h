@@ -0,0 +1,53 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __RO_INDEX_H__
+#define __RO_INDEX_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+// RO read names of one chromosome, sorted by (qhash, qname)
+class RO_chrm_index
+{
+public:
+	RO_chrm_index();
+
+public:
+	vector<size_t> qhashes;			// hash codes of read names, sorted
+	vector<string> qnames;			// read names, parallel to qhashes
+	vector<uint64_t> bloom;			// optional bloom prefilter over qhashes
+	uint64_t bloom_bits;			// number of bits in bloom
+
+public:
+	int build(int bits_per_read);
+	bool contains(size_t qhash, const string &qname) const;
+	bool bloom_test(size_t qhash) const;
+	int size() const;
+};
+
+// shared, read-only index of RO reads partitioned by chromosome
+class RO_index
+{
+public:
+	RO_index();
+
+public:
+	map<string, RO_chrm_index> chrms;	// indexed by chrm name
+	int num_reads;						// number of distinct (chrm, qname)
+
+public:
+	int add(const string &chrm, const string &qname);
+	int build(int bits_per_read);
+	const RO_chrm_index* get(const string &chrm) const;
+	bool contains(const string &chrm, size_t qhash, const string &qname) const;
+	int size() const;
+};
+
+#endif
@@ -11,6 +11,8 @@ See LICENSE for licensing.
 #include <cstdio>
 #include <cassert>
 #include <sstream>
+#include <algorithm>
+#include <chrono>
 
 #include "config.h"
 #include "genome.h"
@@ -37,19 +39,29 @@ assembler::assembler(reference &r)
 	qlen = 0;
 	qcnt = 0;
 	circular_trsts.clear();
-	circular_trsts_long_removed.clear();
-	circ_trst_map.clear();
-	circ_trst_merged_map.clear();
+	circ_mergers.clear();
 	circular_trsts_HS.clear();
 	HS_both_side_reads.clear();
-	RO_reads_map.clear();
 	RO_count = 0;
+	num_gated_bundles = 0;
+	num_unref_bundles = 0;
+	num_small_bundles = 0;
+	num_notid_bundles = 0;
+	num_decoded_reads = 0;
+	count_allocations = (metrics_file != "" || profile_file != "");
+	num_carried_hits = 0;
 	total_frag_count = 0;
 	only_ref_path_frag_count = 0;
 	single_ref_chosen_count = 0;
 	multi_ref_chosen_count = 0;
 	read_cirifull_file();
 
+	if(bundle_cost_file != "")
+	{
+		fcost.open(bundle_cost_file.c_str(), fstream::trunc);
+		fcost << "chrm\tlpos\trpos\tstrand\thits\tspliced_hits\tsuppl_hits\tpredicted_cost\tactual_seconds" << endl;
+	}
+
 	/*if(fai != NULL)
 	{
 		printf("extracting fasta seq from region:\n");
@@ -72,73 +84,21 @@ assembler::~assembler()
 
 int assembler::assemble()
 {
-    while(sam_read1(sfn, hdr, b1t) >= 0)
+	// two-pass mode: scan for back-splice candidates, then fetch their windows;
+	// fall back to streaming all reads if the input is not indexed
+	if(targeted_assembly == false || assemble_targeted() != 0)
 	{
-		if(terminate == true) return 0;
-
-		bam1_core_t &p = b1t->core;
-
-		if(p.tid < 0) continue;
-		if((p.flag & 0x4) >= 1) continue;										// read is not mapped
-		if((p.flag & 0x100) >= 1 && use_second_alignment == false) continue;	// secondary alignment
-		if(p.n_cigar > max_num_cigar) continue;									// ignore hits with more than max-num-cigar types
-		if(p.qual < min_mapping_quality) continue;							// ignore hits with small quality
-		if(p.n_cigar < 1) continue;												// should never happen
-
-		hit ht(b1t, hid++);
-
-		ht.set_tags(b1t);
-		ht.set_strand();
-
-		if(ht.cigar_vector[0].first == 'S' || ht.cigar_vector[ht.cigar_vector.size()-1].first == 'S')
-		{
-			ht.set_seq(b1t);
-		}
-
-		//ht.print();
-
-		//if(ht.nh >= 2 && p.qual < min_mapping_quality) continue;
-		//if(ht.nm > max_edit_distance) continue;
-
-		//if(p.tid > 1) break;
-
-		qlen += ht.qlen;
-		qcnt += 1;
-
-		// truncate
-		if(ht.tid != bb1.tid || ht.pos > bb1.rpos + min_bundle_gap) //ht.tid is chromosome id from defined by bam_hdr_t
-		{
-			if(bb1.hits.size() >= 1) pool.push_back(bb1);
-			bb1.clear();
-		}
-		if(ht.tid != bb2.tid || ht.pos > bb2.rpos + min_bundle_gap)
+		while(sam_read1(sfn, hdr, b1t) >= 0)
 		{
-			if(bb2.hits.size() >= 1) pool.push_back(bb2);
-			bb2.clear();
+			if(terminate == true) return 0;
+			add_read(b1t);
 		}
-
-		// process
-		process(batch_bundle_size);
-
-
-		//printf("read strand = %c, xs = %c, ts = %c\n", ht.strand, ht.xs, ht.ts);
-
-		// add hit
-		if(uniquely_mapped_only == true && ht.nh != 1) continue;
-		if(library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') continue;
-		if(library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') continue;
-		if(library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
-		if(library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
-		if(library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
-
-		// only use bb1 if unstranded
-		if(library_type == UNSTRANDED) bb1.add_hit(ht); //heuristic, adding to both
 	}
 
 	//printf("complete\n");
 
-	if(bb1.hits.size() >= 1) pool.push_back(bb1);
-	if(bb2.hits.size() >= 1) pool.push_back(bb2);
+	flush_bundle(bb1);
+	flush_bundle(bb2);
 
 	process(0);
 
@@ -187,8 +147,28 @@ int assembler::assemble()
 	// printf("total number of fragments that choose only ref path, ref size 1: %d\n",single_ref_chosen_count);
 	// printf("total number of fragments that choose only ref path, ref size > 1: %d\n",multi_ref_chosen_count);
 
-	remove_long_exon_circ_trsts();
-	remove_duplicate_circ_trsts();
+	printf("#bundles skipped without back-splice evidence = %d\n", num_gated_bundles);
+
+	if(profile_file != "")
+	{
+		prof.write(profile_file);
+		prof.print_top(profile_top);
+	}
+	if(split_bundles == true) printf("#hits carried across bundle cuts = %d\n", num_carried_hits);
+
+	metrics.start_postprocessing();
+
+	// bsj-only mode: no circRNA post-processing, report junctions only
+	if(bsj_only == true)
+	{
+		write_bsjs();
+		metrics.finish();
+		if(metrics_file != "") write_metrics();
+		printf("TERRACE run complete!\n");
+		return 0;
+	}
+
+	merge_circ_trsts();
 	print_circular_trsts();
 	write_circular();
 
@@ -197,11 +177,257 @@ int assembler::assemble()
 		write_feature();
 	}
 
+	if(read_assignment_file != "")
+	{
+		write_read_assignment();
+	}
+
+	metrics.finish();
+	if(metrics_file != "") write_metrics();
+
 	printf("TERRACE run complete!\n");
 	
 	return 0;
 }
 
+int assembler::add_read(bam1_t *b)
+{
+	bam1_core_t &p = b->core;
+
+	num_decoded_reads++;
+	if(p.tid < 0) return 0;
+	if((p.flag & 0x4) >= 1) return 0;										// read is not mapped
+	if((p.flag & 0x100) >= 1 && use_second_alignment == false) return 0;	// secondary alignment
+	if(p.n_cigar > max_num_cigar) return 0;									// ignore hits with more than max-num-cigar types
+	if(p.qual < min_mapping_quality) return 0;							// ignore hits with small quality
+	if(p.n_cigar < 1) return 0;												// should never happen
+
+	hit ht(b, hid++);
+
+	ht.set_tags(b);
+	ht.set_strand();
+
+	if(ht.cigar_vector[0].first == 'S' || ht.cigar_vector[ht.cigar_vector.size()-1].first == 'S')
+	{
+		ht.set_seq(b);
+	}
+
+	//ht.print();
+
+	//if(ht.nh >= 2 && p.qual < min_mapping_quality) return 0;
+	//if(ht.nm > max_edit_distance) return 0;
+
+	//if(p.tid > 1) break;
+
+	qlen += ht.qlen;
+	qcnt += 1;
+
+	// stashed hits whose partner should have been met by now are dropped
+	if(split_bundles == true) stash.expire(ht.tid, ht.pos);
+
+	// truncate
+	if(ht.tid != bb1.tid || ht.pos > bb1.rpos + min_bundle_gap) //ht.tid is chromosome id from defined by bam_hdr_t
+	{
+		flush_bundle(bb1);
+	}
+	if(ht.tid != bb2.tid || ht.pos > bb2.rpos + min_bundle_gap)
+	{
+		flush_bundle(bb2);
+	}
+
+	// process
+	process(batch_bundle_size);
+
+
+	//printf("read strand = %c, xs = %c, ts = %c\n", ht.strand, ht.xs, ht.ts);
+
+	// add hit
+	if(uniquely_mapped_only == true && ht.nh != 1) return 0;
+	if(library_type != UNSTRANDED && ht.strand == '+' && ht.xs == '-') return 0;
+	if(library_type != UNSTRANDED && ht.strand == '-' && ht.xs == '+') return 0;
+	if(library_type != UNSTRANDED && ht.strand == '.' && ht.xs != '.') ht.strand = ht.xs;
+	if(library_type != UNSTRANDED && ht.strand == '+') bb1.add_hit(ht);
+	if(library_type != UNSTRANDED && ht.strand == '-') bb2.add_hit(ht);
+
+	// only use bb1 if unstranded
+	if(library_type == UNSTRANDED) bb1.add_hit(ht); //heuristic, adding to both
+
+	// hand over stashed partners of ht from earlier bundles
+	if(split_bundles == true && stash.size() >= 1)
+	{
+		bundle_base *bb = NULL;
+		if(library_type == UNSTRANDED) bb = &bb1;
+		else if(ht.strand == '+') bb = &bb1;
+		else if(ht.strand == '-') bb = &bb2;
+
+		vector<hit> v;
+		if(bb != NULL) stash.resolve(ht, v);
+		for(int k = 0; k < v.size(); k++) bb->add_carried_hit(v[k]);
+		num_carried_hits += v.size();
+	}
+
+	return 0;
+}
+
+int assembler::flush_bundle(bundle_base &bb)
+{
+	if(bb.hits.size() >= 1)
+	{
+		// junctions around hits carried into bb, and read groups with
+		// a mate or supplementary in a later bundle
+		if(split_bundles == true && bb.num_carried_hits >= 1)
+		{
+			vector<hit> v;
+			stash.get_splices(bb.carried_lpos, bb.carried_rpos, v);
+			bb.add_carried_splices(v);
+		}
+		if(split_bundles == true) stash.add(bb.hits, bb.rpos);
+		bb.sort_hits();
+		pool.push_back(bb);
+	}
+	bb.clear();
+	return 0;
+}
+
+int assembler::assemble_targeted()
+{
+	hts_idx_t *idx = sam_index_load(sfn, input_file.c_str());
+	if(idx == NULL)
+	{
+		printf("warning: index of %s is not available, targeted assembly is disabled\n", input_file.c_str());
+		return -1;
+	}
+
+	vector< vector<PI32> > windows;
+	if(scan_bsj_candidates(windows) != 0)
+	{
+		printf("warning: %s cannot be scanned, targeted assembly is disabled\n", input_file.c_str());
+		hts_idx_destroy(idx);
+		return -1;
+	}
+
+	for(int tid = 0; tid < windows.size(); tid++)
+	{
+		int32_t prev = -1;
+		for(int k = 0; k < windows[tid].size(); k++)
+		{
+			const PI32 &w = windows[tid][k];
+			hts_itr_t *itr = sam_itr_queryi(idx, tid, w.first, w.second);
+			if(itr == NULL) continue;
+
+			while(sam_itr_next(sfn, itr, b1t) >= 0)
+			{
+				if(terminate == true) break;
+
+				// reads starting before the previous window's end were fetched there
+				if(b1t->core.pos < prev) continue;
+				add_read(b1t);
+			}
+
+			hts_itr_destroy(itr);
+			prev = w.second;
+		}
+	}
+
+	hts_idx_destroy(idx);
+	return 0;
+}
+
+int assembler::scan_bsj_candidates(vector< vector<PI32> > &windows)
+{
+	// first pass: only core fields, cigar ends and the SA tag are examined
+	samFile *fp = sam_open(input_file.c_str(), "r");
+	if(fp == NULL) return -1;
+
+	bam_hdr_t *h = sam_hdr_read(fp);
+	if(h == NULL)
+	{
+		sam_close(fp);
+		return -1;
+	}
+
+	bam1_t *b = bam_init1();
+
+	windows.clear();
+	windows.resize(h->n_targets);
+
+	int cnt = 0;
+	while(sam_read1(fp, h, b) >= 0)
+	{
+		bam1_core_t &p = b->core;
+
+		if(p.tid < 0) continue;
+		if((p.flag & 0x4) >= 1) continue;
+		if((p.flag & 0x100) >= 1 && use_second_alignment == false) continue;
+		if(p.n_cigar > max_num_cigar) continue;
+		if(p.qual < min_mapping_quality) continue;
+		if(p.n_cigar < 1) continue;
+
+		bool c = false;
+		uint32_t *cigar = bam_get_cigar(b);
+		if((p.flag & 0x800) >= 1) c = true;
+		else if(bam_aux_get(b, "SA") != NULL) c = true;
+		else if(fasta_file != "")
+		{
+			// soft clips that may be rescued in get_more_chimeric
+			uint32_t c1 = cigar[0];
+			uint32_t c2 = cigar[p.n_cigar - 1];
+			if(bam_cigar_op(c1) == BAM_CSOFT_CLIP && bam_cigar_oplen(c1) + flank_tiny_length >= min_soft_clip_len) c = true;
+			if(bam_cigar_op(c2) == BAM_CSOFT_CLIP && bam_cigar_oplen(c2) + flank_tiny_length >= min_soft_clip_len) c = true;
+		}
+
+		if(c == false) continue;
+		cnt++;
+
+		int32_t l = p.pos - targeted_window;
+		int32_t r = p.pos + (int32_t)bam_cigar2rlen(p.n_cigar, cigar) + targeted_window;
+		windows[p.tid].push_back(PI32(l < 0 ? 0 : l, r));
+
+		// also fetch the mate so that the fragment can be formed
+		if(p.mtid == p.tid && (p.flag & 0x8) <= 0)
+		{
+			l = p.mpos - targeted_window;
+			r = p.mpos + targeted_window;
+			windows[p.tid].push_back(PI32(l < 0 ? 0 : l, r));
+		}
+	}
+
+	// merge overlapping windows of each chromosome
+	int n = 0;
+	int64_t len = 0;
+	for(int tid = 0; tid < windows.size(); tid++)
+	{
+		vector<PI32> &v = windows[tid];
+		if(v.size() == 0) continue;
+
+		sort(v.begin(), v.end());
+		int m = 0;
+		for(int k = 1; k < v.size(); k++)
+		{
+			if(v[k].first <= v[m].second + min_bundle_gap)
+			{
+				if(v[k].second > v[m].second) v[m].second = v[k].second;
+			}
+			else
+			{
+				m++;
+				v[m] = v[k];
+			}
+		}
+		v.resize(m + 1);
+
+		n += v.size();
+		for(int k = 0; k < v.size(); k++) len += v[k].second - v[k].first;
+	}
+
+	printf("targeted assembly: %d candidate reads, %d windows, total length = %lld\n", cnt, n, (long long)len);
+
+	bam_destroy1(b);
+	bam_hdr_destroy(h);
+	sam_close(fp);
+	return 0;
+}
+
 int assembler::process(int n)
 {
 	if(pool.size() < n) return 0;
@@ -210,6 +436,9 @@ int assembler::process(int n)
 	{
 		bundle_base &bb = pool[i];
 
+		// ultra-deep bundles are cut down to the hit budget first
+		bb.downsample(max_bundle_hits);
+
 		char buf[1024];
 		strcpy(buf, hdr->target_name[bb.tid]);
 		bb.chrm = string(buf);
@@ -217,7 +446,11 @@ int assembler::process(int n)
 		// skip assemble a bundle if its chrm does not exist in the
 		// reference (given the ref_file is provide)
 
-		if(ref_file != "" && ref.isms0.find(bb.chrm) == ref.isms0.end() && ref.isms1.find(bb.chrm) == ref.isms1.end() && ref.isms2.find(bb.chrm) == ref.isms2.end()) continue;
+		if(ref_file != "" && ref.isms0.find(bb.chrm) == ref.isms0.end() && ref.isms1.find(bb.chrm) == ref.isms1.end() && ref.isms2.find(bb.chrm) == ref.isms2.end())
+		{
+			num_unref_bundles++;
+			continue;
+		}
 
 		/*
 		// calculate the number of hits with splices
@@ -239,14 +472,55 @@ int assembler::process(int n)
 			else cnt2++;
 		}
 
-		if(cnt1 + cnt2 < min_num_hits_in_bundle) continue;
+		if(cnt1 + cnt2 < min_num_hits_in_bundle || cnt1 + cnt2 == 0)
+		{
+			num_small_bundles++;
+			continue;
+		}
 		//if(cnt1 < 5 && cnt1 * 2 + cnt2 < min_num_hits_in_bundle) continue;
-		if(bb.tid < 0) continue;
+		if(bb.tid < 0)
+		{
+			num_notid_bundles++;
+			continue;
+		}
+
+		// skip bundles that cannot yield a circRNA
+		if(use_evidence_gate == true && bb.has_bsj_evidence() == false)
+		{
+			num_gated_bundles++;
+			continue;
+		}
 
 		transcript_set ts1(bb.chrm, 0.9);		// full-length set
 		transcript_set ts2(bb.chrm, 0.9);		// non-full-length set
 
-		bundle_bridge br(bb, ref, RO_reads_map, fai);
+		double cost = bb.estimate_cost();
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+		bundle_profile bp;
+		bool profiled = (profile_file != "" || metrics_file != "");
+		bundle_bridge br(bb, ref, RO_reads_index, fai, profiled ? &bp : NULL);
+		if(profile_file != "") prof.add(bp);
+		if(metrics_file != "") metrics.add(bp);
+
+		if(fcost.is_open())
+		{
+			double t = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+			fcost << bb.chrm.c_str() << "\t" << bb.lpos << "\t" << bb.rpos << "\t" << bb.strand << "\t";
+			fcost << bb.hits.size() << "\t" << bb.num_spliced_hits << "\t" << bb.num_suppl_hits + bb.num_sa_hits << "\t";
+			fcost << cost << "\t" << t << endl;
+		}
+
+		if(bsj_only == true)
+		{
+			map<int64_t, PI> &m = bsj_map[pair<string, char>(bb.chrm, bb.strand)];
+			for(map<int64_t, PI>::iterator it = br.bsj_counts.begin(); it != br.bsj_counts.end(); it++)
+			{
+				m[it->first].first += it->second.first;
+				m[it->first].second += it->second.second;
+			}
+			continue;
+		}
 
 		RO_count += br.RO_count;
 		total_frag_count += br.total_frag_count;
@@ -254,8 +528,9 @@ int assembler::process(int n)
 		single_ref_chosen_count += br.single_ref_chosen_count;
 		multi_ref_chosen_count += br.multi_ref_chosen_count;
 
+		intern_supporting_reads(br.circ_trsts, br.qtable);
+		intern_supporting_reads(br.circ_trsts_HS, br.qtable);
 		circular_trsts.insert(circular_trsts.end(), br.circ_trsts.begin(), br.circ_trsts.end());
-
 		circular_trsts_HS.insert(circular_trsts_HS.end(), br.circ_trsts_HS.begin(), br.circ_trsts_HS.end());
 
 		// RO statistics
@@ -308,232 +583,66 @@ int assembler::process(int n)
 		if(ft2.trs.size() >= 1) non_full_trsts.insert(non_full_trsts.end(), ft2.trs.begin(), ft2.trs.end());*/ //commented to make efficient
 
 	}
+
 	pool.clear();
 	//printf("End of bundle-----------\n");
+
+	if(metrics_file != "" && metrics.due(metrics_interval)) write_metrics();
 	return 0;
 }
 
-int assembler::remove_long_exon_circ_trsts()
+int assembler::intern_supporting_reads(vector<circular_transcript> &v, const qname_table &qt)
 {
-	for(int i=0;i<circular_trsts.size();i++)
-	{	
-		circular_transcript circ = circular_trsts[i];
-		int long_flag = 0;
-		
-		//remove long exon FP
-		if(circ.merged_regions.size() == 1) //check for single exons
-		{
-			for(int j=0;j<circ.merged_regions.size();j++)
-			{
-				if(circ.merged_regions[j].rpos-circ.merged_regions[j].lpos > max_single_exon_length)
-				{
-					long_flag = 1;
-					break;
-				}
-			}
-		}
-		else if(circ.merged_regions.size() > 1) //check for multi exons
-		{
-			for(int j=0;j<circ.merged_regions.size();j++)
-			{
-				if(circ.merged_regions[j].rpos-circ.merged_regions[j].lpos > max_multi_exon_length)
-				{
-					long_flag = 1;
-					break;
-				}
-			}
-		}
-
-		//try to remove FP by discarding circRNAs with lots of vertices from many small junctions
-		if(circ.circ_path.size() > max_circ_vsize)
-		{
-			long_flag = 1;
-		}
-
-		if(long_flag == 0)
-		{
-			circular_trsts_long_removed.push_back(circ);
-		}
-
-		if(long_flag == 1)
+	// map qname ids of a bundle to run-wide ids before the bundle is released
+	for(int i = 0; i < v.size(); i++)
+	{
+		vector<int32_t> &r = v[i].reads;
+		for(int k = 0; k < r.size(); k++)
 		{
-			//printf("Printing long exon circRNAs removed:\n");
-			//circ.print(i+1);
+			int x = r[k];
+			assert(x >= 0 && x < qt.size());
+			r[k] = read_pool.intern(qt.qhashes[x], *qt.qnames[x]);
 		}
 	}
 	return 0;
 }
 
-int assembler::remove_duplicate_circ_trsts()
+int assembler::merge_circ_trsts()
 {
-	for(int i=0;i<circular_trsts_long_removed.size();i++)
+	// partition candidates by chromosome; merging never crosses chromosomes
+	map<string, int> m;
+	for(int i = 0; i < circular_trsts.size(); i++)
 	{
-		circular_transcript circ = circular_trsts_long_removed[i];
-
-		if(circ_trst_map.find(circ.circRNA_id) != circ_trst_map.end())// already circRNA present in map
-		{
-			//increase coverage count
-			circ_trst_map[circ.circRNA_id].second++;
-
-			//accumulate features of all identical circRNAs
-			circ_trst_map[circ.circRNA_id].first.supple_len = circ_trst_map[circ.circRNA_id].first.supple_len + min(circ.supple_len,read_length-circ.supple_len);
-			circ_trst_map[circ.circRNA_id].first.path_score = circ_trst_map[circ.circRNA_id].first.path_score + circ.path_score;
-			circ_trst_map[circ.circRNA_id].first.fake_count = circ_trst_map[circ.circRNA_id].first.fake_count + circ.fake_count;
-			circ_trst_map[circ.circRNA_id].first.path_count_1 = circ_trst_map[circ.circRNA_id].first.path_count_1 + circ.path_count_1;
-			circ_trst_map[circ.circRNA_id].first.path_count_2 = circ_trst_map[circ.circRNA_id].first.path_count_2 + circ.path_count_2;
-			circ_trst_map[circ.circRNA_id].first.path_count_3 = circ_trst_map[circ.circRNA_id].first.path_count_3 + circ.path_count_3;
-			circ_trst_map[circ.circRNA_id].first.path_count_4 = circ_trst_map[circ.circRNA_id].first.path_count_4 + circ.path_count_4;
-			circ_trst_map[circ.circRNA_id].first.candidate_path_count= circ_trst_map[circ.circRNA_id].first.candidate_path_count + circ.candidate_path_count;
-
-			//concatenate all hit names of hits generating this circRNA as the circRNA transcript_id
-			circ_trst_map[circ.circRNA_id].first.transcript_id = circ_trst_map[circ.circRNA_id].first.transcript_id + "|" + circ.transcript_id; 
-		}
-		else //circRNA not present in map
-		{
-			circ.supple_len = min(circ.supple_len,read_length-circ.supple_len);
-			circ_trst_map.insert(pair<string,pair<circular_transcript, int>>(circ.circRNA_id,pair<circular_transcript, int>(circ,1)));
-		}
+		const string &chrm = circular_trsts[i].seqname;
+		if(m.find(chrm) != m.end()) continue;
+		m.insert(pair<string, int>(chrm, 0));
 	}
-	printf("circ_trst_map size = %lu\n",circ_trst_map.size());
 
-	map<string, pair<circular_transcript, int>>::iterator itn;
-	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
+	circ_mergers.clear();
+	for(map<string, int>::iterator it = m.begin(); it != m.end(); it++)
 	{
-		circular_transcript &circ = itn->second.first;
-		//set score and coverage
-		circ.coverage = itn->second.second;
-		circ.score = (double)circ.coverage;
-		
-		//printf("key = %s, count = %d\n",itn->first.c_str(),itn->second.second);
+		circ_mergers.push_back(circ_merger(it->first));
 	}
+	sort(circ_mergers.begin(), circ_mergers.end(), compare_circ_merger_chrm);
+	for(int i = 0; i < circ_mergers.size(); i++) m[circ_mergers[i].chrm] = i;
 
-	//merge circRNAs that have different end boundaries but same intron chain into that with higher coverage (chimeric)
-	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
+	for(int i = 0; i < circular_trsts.size(); i++)
 	{
-		//printf("start of check\n");
-		circular_transcript &circ = itn->second.first;
-		string hash = itn->first;
-
-		if(circ.source != "TERRACE") continue;
-
-		vector<string> split_coordinates = split_str(hash,"|");
-
-		//creating new hash with middle cordinates except first and last coordinate
-		string intron_chain_hash = "";
-		for(int i=3;i<split_coordinates.size()-2;i++)
-		{
-			intron_chain_hash = intron_chain_hash + split_coordinates[i] + "|";
-		}
-
-		int flag_collision = 0;
-		map<string, pair<circular_transcript, int>>::iterator itn1;
-		for(itn1 = circ_trst_merged_map.begin(); itn1 != circ_trst_merged_map.end(); itn1++)
-		{
-			circular_transcript &old_circ = itn1->second.first;
-			string old_hash = itn1->first;
-
-			//don't check with already existing RO circRNAs
-			//if(old_circ.source == "scallop2_RO") continue;
-			
-			vector<string> old_split_coordinates = split_str(old_hash,"|");
-			string old_intron_chain_hash = "";
-			for(int i=3;i<old_split_coordinates.size()-2;i++)
-			{
-				old_intron_chain_hash = old_intron_chain_hash + old_split_coordinates[i] + "|";
-			}
-
-			//printf("%s & %s\n",circ.circRNA_id.c_str(),old_circ.circRNA_id.c_str());
-			//printf("start diff %d. end diff %d, hash1 %s, hash2 %s\n",abs(circ.start-old_circ.start),abs(circ.end-old_circ.end),intron_chain_hash.c_str(),old_intron_chain_hash.c_str());
-
-			//&& abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff 
-			if((intron_chain_hash != "" && intron_chain_hash == old_intron_chain_hash && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff) || (intron_chain_hash == "" && intron_chain_hash == old_intron_chain_hash && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff))
-			{
-				if(circ.coverage > old_circ.coverage)
-				{
-					circ_trst_merged_map.erase(itn1->first);
-					circ_trst_merged_map.insert(pair<string,pair<circular_transcript, int>>(circ.circRNA_id,pair<circular_transcript, int>(circ,circ.coverage)));
-					flag_collision = 1;
-					break;
-				}
-				flag_collision = 1;
-			}
-		}
-
-		if(flag_collision == 0) //end diff and intron chain condition did not match for any entry in circ_trst_merged_map, so enter separately
-		{
-			circ_trst_merged_map.insert(pair<string,pair<circular_transcript, int>>(circ.circRNA_id,pair<circular_transcript, int>(circ,circ.coverage)));
-		}
-	}
-
-	//merge circRNAs that have different end boundaries but same intron chain into that with higher coverage (more chimeric)
-	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
-	{
-		//printf("start of check\n");
-		circular_transcript &circ = itn->second.first;
-		string hash = itn->first;
-
-		if(circ.source != "TERRACE_NEW") continue;
-
-		vector<string> split_coordinates = split_str(hash,"|");
-
-		//creating new hash with middle cordinates except first and last coordinate
-		string intron_chain_hash = "";
-		for(int i=3;i<split_coordinates.size()-2;i++)
-		{
-			intron_chain_hash = intron_chain_hash + split_coordinates[i] + "|";
-		}
-
-		int flag_collision = 0;
-		map<string, pair<circular_transcript, int>>::iterator itn1;
-		for(itn1 = circ_trst_merged_map.begin(); itn1 != circ_trst_merged_map.end(); itn1++)
-		{
-			circular_transcript &old_circ = itn1->second.first;
-			string old_hash = itn1->first;
-
-			//don't check with already existing RO circRNAs
-			//if(old_circ.source == "scallop2_RO") continue;
-			
-			vector<string> old_split_coordinates = split_str(old_hash,"|");
-			string old_intron_chain_hash = "";
-			for(int i=3;i<old_split_coordinates.size()-2;i++)
-			{
-				old_intron_chain_hash = old_intron_chain_hash + old_split_coordinates[i] + "|";
-			}
-
-			//printf("%s & %s\n",circ.circRNA_id.c_str(),old_circ.circRNA_id.c_str());
-			//printf("start diff %d. end diff %d, hash1 %s, hash2 %s\n",abs(circ.start-old_circ.start),abs(circ.end-old_circ.end),intron_chain_hash.c_str(),old_intron_chain_hash.c_str());
-
-			//&& abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff 
-			if((intron_chain_hash != "" && intron_chain_hash == old_intron_chain_hash && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff) || (intron_chain_hash == "" && intron_chain_hash == old_intron_chain_hash && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff))
-			{
-				if(circ.coverage > old_circ.coverage)
-				{
-					circ_trst_merged_map.erase(itn1->first);
-					circ_trst_merged_map.insert(pair<string,pair<circular_transcript, int>>(circ.circRNA_id,pair<circular_transcript, int>(circ,circ.coverage)));
-					flag_collision = 1;
-					break;
-				}
-				flag_collision = 1;
-			}
-		}
-
-		if(flag_collision == 0) //end diff and intron chain condition did not match for any entry in circ_trst_merged_map, so enter separately
-		{
-			circ_trst_merged_map.insert(pair<string,pair<circular_transcript, int>>(circ.circRNA_id,pair<circular_transcript, int>(circ,circ.coverage)));
-		}
+		int k = m[circular_trsts[i].seqname];
+		circ_mergers[k].circular_trsts.push_back(circular_trsts[i]);
 	}
+	circular_trsts.clear();
 
-	printf("circ_trst_merged_map size = %lu\n",circ_trst_merged_map.size());
+	process_circ_mergers(circ_mergers, num_threads);
 
-	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	size_t n1 = 0, n2 = 0;
+	for(int i = 0; i < circ_mergers.size(); i++)
 	{
-		circular_transcript &circ = itn->second.first;
-		circ.coverage = itn->second.second;
-		//circ.score = circ.score/circ.bundle_size;
-		//printf("key = %s, count = %d\n",itn->first.c_str(),itn->second.second);
+		n1 += circ_mergers[i].circ_trst_map.size();
+		n2 += circ_mergers[i].circ_trst_merged_map.size();
 	}
-
-
+	printf("circ_trst_map size = %lu\n", n1);
+	printf("circ_trst_merged_map size = %lu\n", n2);
 	return 0;
 }
 
@@ -624,21 +733,11 @@ int assembler::read_cirifull_file()
 
 	for(int i=0;i<RO_reads.size();i++)
 	{
-		RO_read ro_read = RO_reads[i];
-		string hash = "";
-		hash = hash + ro_read.chrm + ":" + ro_read.read_name;
-
-		if(RO_reads_map.find(hash) != RO_reads_map.end())
-		{
-			RO_reads_map[hash]++;
-		}
-		else
-		{
-			RO_reads_map[hash] = 1;
-		}
+		RO_reads_index.add(RO_reads[i].chrm, RO_reads[i].read_name);
 	}
+	RO_reads_index.build(ro_bloom_bits);
 	
-	printf("RO_reads map size: %lu\n",RO_reads_map.size());
+	printf("RO_reads index size: %d\n",RO_reads_index.size());
 	
 	return 0;
 }
@@ -647,12 +746,16 @@ int assembler::print_circular_trsts()
 {
 	printf("\nPrinting all circRNAs\n");
 
-	map<string, pair<circular_transcript, int>>::iterator itn;
+	map<circ_key, pair<circular_transcript, int>>::iterator itn;
 	int cnt = 1;
-	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	for(int i = 0; i < circ_mergers.size(); i++)
 	{
-		circular_transcript &circ = itn->second.first;
-		circ.print(cnt++);
+		circ_merger &cm = circ_mergers[i];
+		for(itn = cm.circ_trst_merged_map.begin(); itn != cm.circ_trst_merged_map.end(); itn++)
+		{
+			circular_transcript &circ = itn->second.first;
+			circ.print(cnt++);
+		}
 	}
 
 	printf("\n");
@@ -725,11 +828,10 @@ int assembler::write_circular()
 		return 0;
 	}
 
-	map<string, pair<circular_transcript, int>>::iterator itn;
-	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	// records are rendered per chromosome by merge_circ_trsts
+	for(int i = 0; i < circ_mergers.size(); i++)
 	{
-		circular_transcript &circ = itn->second.first;
-		circ.write(fcirc);
+		fcirc << circ_mergers[i].gtf;
 	}
 
 	/*for(int i = 0; i < circular_trsts.size(); i++)
@@ -744,6 +846,40 @@ int assembler::write_circular()
 }
 
 
+int assembler::write_bsjs()
+{
+	// BED6 plus the number of soft-clip rescued reads; score is the read count
+	ofstream fout(output_file.c_str(), fstream::trunc);
+
+	if(fout.fail())
+	{
+		printf("failed to open %s\n", output_file.c_str());
+		return 0;
+	}
+
+	int cnt = 0;
+	map<pair<string, char>, map<int64_t, PI> >::iterator it;
+	for(it = bsj_map.begin(); it != bsj_map.end(); it++)
+	{
+		const string &chrm = it->first.first;
+		char strand = it->first.second;
+		map<int64_t, PI>::iterator itn;
+		for(itn = it->second.begin(); itn != it->second.end(); itn++)
+		{
+			int32_t start = high32(itn->first);
+			int32_t end = low32(itn->first);
+			fout << chrm.c_str() << "\t" << start << "\t" << end << "\t";
+			fout << chrm.c_str() << ":" << start << "|" << end << "|" << "\t";
+			fout << itn->second.first << "\t" << strand << "\t" << itn->second.second << endl;
+			cnt++;
+		}
+	}
+
+	fout.close();
+	printf("#back-splice junctions = %d\n", cnt);
+	return 0;
+}
+
 int assembler::write_feature()
 {
 	//printf("file - %s", output_circ_file.c_str());
@@ -755,15 +891,115 @@ int assembler::write_feature()
 		return 0;
 	}
 
-	fout<<"circRNA_id"<<","<<"bundle_size"<<","<<"ref_trsts_size"<<","<<"coverage"<<","<<"fake_count"<<","<<"supple_len"<<","<<"candidate_path_count"<<","<<"path_score"<<","<<"path_count_1"<<","<<"path_count_2"<<","<<"path_count_3"<<","<<"path_count_4"<<","<<"exon_count"<<","<<"total_exon_len"<<","<<"max_exon_len"<<","<<"min_exon_len"<<","<<"avg_exon_len"<<"\n";
-	map<string, pair<circular_transcript, int>>::iterator itn;
-	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	fout<<"circRNA_id"<<","<<"bundle_size"<<","<<"ref_trsts_size"<<","<<"coverage"<<","<<"fake_count"<<","<<"supple_len"<<","<<"candidate_path_count"<<","<<"path_score"<<","<<"path_count_1"<<","<<"path_count_2"<<","<<"path_count_3"<<","<<"path_count_4"<<","<<"exon_count"<<","<<"total_exon_len"<<","<<"max_exon_len"<<","<<"min_exon_len"<<","<<"avg_exon_len";
+	if(max_bundle_hits > 0) fout<<","<<"sample_rate";	// only with downsampling, keeps the default layout of the RF model
+	fout<<"\n";
+	for(int i = 0; i < circ_mergers.size(); i++)
+	{
+		fout<<circ_mergers[i].features;
+	}
+
+	fout.close();
+
+	return 0;
+}
+
+int assembler::write_read_assignment()
+{
+	// one line per (read, circRNA) pair: qname and circRNA id
+	ofstream fout(read_assignment_file.c_str(), fstream::trunc);
+
+	if(fout.fail())
+	{
+		printf("failed to open %s\n", read_assignment_file.c_str());
+		return 0;
+	}
+
+	int cnt = 0;
+	map<circ_key, pair<circular_transcript, int>>::iterator itn;
+	for(int i = 0; i < circ_mergers.size(); i++)
+	for(itn = circ_mergers[i].circ_trst_merged_map.begin(); itn != circ_mergers[i].circ_trst_merged_map.end(); itn++)
 	{
 		circular_transcript &circ = itn->second.first;
-		fout<<circ.circRNA_id<<","<<circ.bundle_size<<","<<circ.ref_trsts_size<<","<<circ.coverage<<","<<circ.fake_count<<","<<circ.supple_len<<","<<circ.candidate_path_count<<","<<circ.path_score<<","<<circ.path_count_1<<","<<circ.path_count_2<<","<<circ.path_count_3<<","<<circ.path_count_4<<","<<circ.exon_count<<","<<circ.total_exon_length<<","<<circ.max_exon_length<<","<<circ.min_exon_length<<","<<circ.avg_exon_length<<"\n";
+		string id = circ.key.str();
+
+		// reads are distinct after merging
+		for(int k = 0; k < circ.reads.size(); k++)
+		{
+			fout << read_pool.get(circ.reads[k]).c_str() << "\t" << id.c_str() << "\n";
+			cnt++;
+		}
 	}
 
+	fout.close();
+	printf("#read assignments = %d\n", cnt);
+	return 0;
+}
+
+int assembler::set_preview_time(double t)
+{
+	metrics.preview_seconds = t;
+	return 0;
+}
+
+int assembler::write_metrics()
+{
+	// written to a temporary file first so readers never see a partial report
+	string tmp = metrics_file + ".tmp";
+	ofstream fout(tmp.c_str(), fstream::trunc);
+	if(fout.fail())
+	{
+		printf("failed to open %s\n", tmp.c_str());
+		return 0;
+	}
+
+	double ta = metrics.assembly_seconds();
+	double tp = metrics.postprocessing_seconds();
+	size_t ncirc = 0;
+	for(int i = 0; i < circ_mergers.size(); i++) ncirc += circ_mergers[i].circ_trst_merged_map.size();
+
+	fout << "{\n";
+	fout << "  \"version\": \"" << json_escape(version) << "\",\n";
+	fout << "  \"status\": \"" << (metrics.done ? "done" : (metrics.postprocessing ? "postprocessing" : "assembling")) << "\",\n";
+	fout << "  \"seconds\": {\"preview\": " << metrics.preview_seconds << ", \"assembly\": " << ta << ", \"postprocessing\": " << tp << "},\n";
+	fout << "  \"reads\": {\"decoded\": " << num_decoded_reads << ", \"hits\": " << qcnt << ", \"decoded_per_second\": " << (ta > 0 ? num_decoded_reads / ta : 0) << "},\n";
+	fout << "  \"bundles\": {\"assembled\": " << metrics.num_bundles << ", \"per_second\": " << (ta > 0 ? metrics.num_bundles / ta : 0) << ", ";
+	fout << "\"skipped\": {\"not_in_reference\": " << num_unref_bundles << ", \"too_few_hits\": " << num_small_bundles << ", ";
+	fout << "\"invalid_chrm\": " << num_notid_bundles << ", \"no_bsj_evidence\": " << num_gated_bundles << "}, ";
+	fout << "\"carried_hits\": " << num_carried_hits << "},\n";
+	fout << "  \"peak_rss_kb\": " << get_peak_rss_kb() << ",\n";
+	fout << "  \"allocations\": " << get_num_allocations() << ",\n";
+
+	fout << "  \"stages\": {";
+	for(int k = 0; k < NUM_PROFILE_STAGES; k++)
+	{
+		if(k >= 1) fout << ", ";
+		fout << "\"" << profile_stage_names[k] << "\": {\"seconds\": " << metrics.stage_seconds[k] << ", \"allocations\": " << metrics.stage_allocations[k] << "}";
+	}
+	fout << "},\n";
+
+	fout << "  \"counters\": {\"RO_count\": " << RO_count << ", \"total_frag_count\": " << total_frag_count << ", ";
+	fout << "\"only_ref_path_frag_count\": " << only_ref_path_frag_count << ", \"single_ref_chosen_count\": " << single_ref_chosen_count << ", ";
+	fout << "\"multi_ref_chosen_count\": " << multi_ref_chosen_count << ", \"h1_supp_count\": " << h1_supp_count << ", \"h2_supp_count\": " << h2_supp_count << ", ";
+	fout << "\"circRNAs\": " << ncirc << ",\n";
+
+	const map<string, int> *freqs[2] = {&frag2graph_freq, &circ_frag_bridged_freq};
+	const char *names[2] = {"frag2graph_freq", "circ_frag_bridged_freq"};
+	for(int k = 0; k < 2; k++)
+	{
+		fout << "    \"" << names[k] << "\": {";
+		for(map<string, int>::const_iterator it = freqs[k]->begin(); it != freqs[k]->end(); it++)
+		{
+			if(it != freqs[k]->begin()) fout << ", ";
+			fout << "\"" << json_escape(it->first) << "\": " << it->second;
+		}
+		fout << "}" << (k == 0 ? ",\n" : "\n");
+	}
+	fout << "  }\n";
+	fout << "}\n";
 	fout.close();
 
+	rename(tmp.c_str(), metrics_file.c_str());
+	metrics.last_write = chrono::steady_clock::now();
 	return 0;
 }
@@ -20,7 +20,13 @@ See LICENSE for licensing.
 
 #include "region.h"
 #include "circular_transcript.h"
+#include "circ_merger.h"
 #include "RO_read.h"
+#include "RO_index.h"
+#include "mate_stash.h"
+#include "qname_table.h"
+#include "profiler.h"
+#include "run_metrics.h"
 #include "htslib/faidx.h"
 
 using namespace std;
@@ -48,16 +54,26 @@ private:
 	double qlen;
 
 	vector<circular_transcript> circular_trsts; //a vector of circular transcripts class objs from all bundles
-	vector<circular_transcript> circular_trsts_long_removed; //a vector of circular transcripts class objs from all bundles, with long exon circs removed
-	map <string, pair<circular_transcript, int>> circ_trst_map; // a map of distinct circ trsts with circRNA_id as key and the corresponding circRNA object
-	map <string, pair<circular_transcript, int>> circ_trst_merged_map; // map with circRNAs having few bp diff ends but same intron chains merged
+	vector<circ_merger> circ_mergers; //post-processed circRNAs of each chromosome, in output order
 
 	vector<circular_transcript> circular_trsts_HS;///a vector of circular transcripts class objs from all HS reads from all bundles
 	vector<string> HS_both_side_reads; //for statistics of RO reads from CIRI-full
 	vector<string> chimeric_reads; //for statistics of RO reads from CIRI-full
 	vector<RO_read> RO_reads; //list of RO reads from CIRI-full simu_ro2_info.list
-	map <string, int> RO_reads_map; //map of RO read name concatenated with chrm
+	RO_index RO_reads_index; //shared read-only index of RO read names partitioned by chrm
+	qname_pool read_pool; //interned names of reads supporting circRNAs, indexed by circular_transcript::reads
 	int RO_count;
+	map<pair<string, char>, map<int64_t, PI> > bsj_map;	// bsj-only mode: (chrm, strand) -> BSJ (start, end) -> (#reads, #soft-clip rescued reads)
+	ofstream fcost;			// per-bundle cost report, open if bundle_cost_file is given
+	profiler prof;			// per-stage profiles of bundles, filled if profile_file is given
+	run_metrics metrics;	// run-wide timing and stage totals, reported if metrics_file is given
+	int64_t num_decoded_reads;	//number of reads decoded from the input
+	mate_stash stash;		// hits waiting for a partner in a later bundle (split_bundles)
+	int num_carried_hits;	//number of hits handed over to a later bundle by the stash
+	int num_gated_bundles;	//number of bundles skipped for lacking back-splice evidence
+	int num_unref_bundles;	//number of bundles skipped as their chrm is not in the reference
+	int num_small_bundles;	//number of bundles skipped for having too few hits
+	int num_notid_bundles;	//number of bundles skipped for lacking a valid chrm
 	int total_frag_count;	//for statistics of how many frags choose only ref path
 	int only_ref_path_frag_count;	//for statistics of how many frags choose only ref path
 	int single_ref_chosen_count;	//for statistics of how many frags choose only ref path when refsize is 1
@@ -65,19 +81,28 @@ private:
 
 public:
 	int assemble();
+	int set_preview_time(double t);
 
 private:
+	int add_read(bam1_t *b);
+	int assemble_targeted();
+	int scan_bsj_candidates(vector< vector<PI32> > &windows);
+	int flush_bundle(bundle_base &bb);
 	int process(int n);
-	int remove_duplicate_circ_trsts();
-	int remove_long_exon_circ_trsts();
+	int intern_supporting_reads(vector<circular_transcript> &v, const qname_table &qt);
+	int merge_circ_trsts();
 	vector<string> split_str(string str, string delimiter);
 	int print_circular_trsts();
 	int write_RO_info();
 	int write_circular_boundaries();
 	int write_circular();
+	int write_bsjs();
 	int write_feature();
+	int write_read_assignment();
+	int write_metrics();
 	int read_cirifull_file();
 	int split(const std::string &s, char delim, std::vector<std::string> &elems);
 };
 
+
 #endif
@@ -35,6 +35,9 @@ bridger::bridger(bundle_bridge *b)
 {
 	bd = b;
 	max_pnode_length = 50;
+	jfrags = NULL;
+	num_path_nodes = 0;
+	num_dp_cells = 0;
 }
 
 int bridger::bridge_normal_fragments()
@@ -232,7 +235,7 @@ int bridger::bridge_clip(int32_t p1, int32_t p2, circular_transcript &circ)
 
 		for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 		{
-			region r(lower(it->first), upper(it->first), '.', '.');
+			region_span r(lower(it->first), upper(it->first));
 			circ.merged_regions.push_back(r);
 		}
 	}
@@ -368,8 +371,8 @@ int bridger::cluster_open_fragments(vector<fcluster> &fclusters, vector<fragment
 		else
 		{
 			if(fc.fset.size() >= 1) fclusters.push_back(fc);
-			vv1 = fr->h1->vlist;
-			vv2 = fr->h2->vlist;
+			vv1.assign(fr->h1->vlist.begin(), fr->h1->vlist.end());
+			vv2.assign(fr->h2->vlist.begin(), fr->h2->vlist.end());
 			fc.clear();
 			fc.type = 0;
 			fc.fset.push_back(fr);
@@ -383,31 +386,191 @@ int bridger::cluster_open_fragments(vector<fcluster> &fclusters, vector<fragment
 
 int bridger::build_junction_graph(vector<fragment> &frags)
 {
-	pnodes.clear();
-	build_path_nodes(2, frags);
-	add_consecutive_path_nodes();
+	// the graph is kept across bridging rounds: a fragment contributes
+	// its bridging path, otherwise its hits contribute their vlists;
+	// later calls only apply fragments whose contribution has changed
+	bool b = (jfrags == &frags && jheads.size() == frags.size());
+	for(int i = 0; b == true && i < frags.size(); i++)
+	{
+		if(jheads[i] != frags[i].h1) b = false;
+	}
+
+	if(b == false) init_junction_graph(frags);
+	else sync_junction_graph(frags);
+
+	max_pnode_length = 2;
+	build_junction_pnodes();
+	return 0;
+}
+
+int bridger::init_junction_graph(vector<fragment> &frags)
+{
+	jfrags = &frags;
+	jnodes.clear();
+	jheads.resize(frags.size());
+	jpaths.assign(frags.size(), vector<int>());
+	jexcl.assign(bd->bb.hits.size(), 0);
+
+	for(int i = 0; i < frags.size(); i++)
+	{
+		fragment &fr = frags[i];
+		jheads[i] = fr.h1;
+		get_junction_path(fr, jpaths[i]);
+		if(jpaths[i].size() == 0) continue;
+		add_junction_nodes(jpaths[i], fr.cnt, false);
+		set_hit_exclusion(fr, 1);
+	}
+
+	for(int i = 0; i < bd->bb.hits.size(); i++)
+	{
+		if(jexcl[i] >= 1) continue;
+		add_junction_nodes(decode_vlist(bd->bb.hits[i].vlist), 1, false);
+	}
 
 	int n = bd->regions.size();
-	jsetx.clear();
-	jsety.clear();
-	jsetx.resize(n);
-	jsety.resize(n);
+	jsetx.assign(n, map<int, int>());
+	jsety.assign(n, map<int, int>());
 
-	for(int i = 0; i < pnodes.size(); i++)
+	for(map<vector<int>, int>::iterator it = jnodes.begin(); it != jnodes.end(); it++)
 	{
-		vector<int> &v = pnodes[i].v;
-		assert(v.size() <= 2);
+		const vector<int> &v = it->first;
 		if(v.size() <= 1) continue;
-		int w = (int)(pnodes[i].score);
-		int x = v[0];
-		int y = v[1];
+		jsetx[v[0]].insert(PI(v[1], it->second));
+		jsety[v[1]].insert(PI(v[0], it->second));
+	}
 
-		assert(jsetx[x].find(y) == jsetx[x].end());
-		assert(jsety[y].find(x) == jsety[y].end());
-		jsetx[x].insert(PI(y, w));
-		jsety[y].insert(PI(x, w));
+	// adjacent regions are always connected
+	for(int i = 0; i < n - 1; i++)
+	{
+		if(jsetx[i].find(i + 1) != jsetx[i].end()) continue;
+		if(bd->regions[i].rpos != bd->regions[i + 1].lpos) continue;
+		jsetx[i].insert(PI(i + 1, 1));
+		jsety[i + 1].insert(PI(i, 1));
+	}
+	return 0;
+}
+
+int bridger::sync_junction_graph(vector<fragment> &frags)
+{
+	vector<int> v;
+	for(int i = 0; i < frags.size(); i++)
+	{
+		fragment &fr = frags[i];
+		get_junction_path(fr, v);
+		if(v == jpaths[i]) continue;
+
+		if(jpaths[i].size() >= 1) add_junction_nodes(jpaths[i], 0 - fr.cnt, true);
+		if(v.size() >= 1) add_junction_nodes(v, fr.cnt, true);
+
+		if(jpaths[i].size() == 0) set_hit_exclusion(fr, 1);
+		if(v.size() == 0) set_hit_exclusion(fr, -1);
+
+		jpaths[i].swap(v);
+	}
+	return 0;
+}
+
+int bridger::get_junction_path(const fragment &fr, vector<int> &v)
+{
+	v.clear();
+	if(fr.paths.size() != 1 || fr.paths[0].type != 1) return 0;
+	v = decode_vlist(fr.paths[0].v);
+	if(v.size() <= 1) v.clear();
+	return 0;
+}
+
+int bridger::add_junction_nodes(const vector<int> &v, int cnt, bool e)
+{
+	// same path nodes as build_path_nodes(m, v, cnt) with max_pnode_length 2;
+	// if e is true, the affected edges are updated as well
+	if(v.size() <= 0) return 0;
+	int n = v.size() < 2 ? v.size() : 2;
+
+	for(int i = 0; i <= v.size() - n; i++)
+	{
+		vector<int> s(v.begin() + i, v.begin() + i + n);
+		map<vector<int>, int>::iterator it = jnodes.find(s);
+		if(it == jnodes.end()) jnodes.insert(pair<vector<int>, int>(s, cnt));
+		else if(it->second + cnt == 0) jnodes.erase(it);
+		else it->second += cnt;
+
+		if(e == true && n == 2) set_junction_edge(s[0], s[1]);
+	}
+	return 0;
+}
+
+int bridger::set_junction_edge(int x, int y)
+{
+	vector<int> s(2);
+	s[0] = x;
+	s[1] = y;
+
+	int w = 0;
+	map<vector<int>, int>::iterator it = jnodes.find(s);
+	if(it != jnodes.end()) w = it->second;
+	else if(y == x + 1 && bd->regions[x].rpos == bd->regions[y].lpos) w = 1;
+
+	if(w == 0)
+	{
+		jsetx[x].erase(y);
+		jsety[y].erase(x);
+	}
+	else
+	{
+		jsetx[x][y] = w;
+		jsety[y][x] = w;
 	}
-	
+	return 0;
+}
+
+int bridger::set_hit_exclusion(const fragment &fr, int d)
+{
+	// hits of a contributing fragment are left out; when a hit enters or
+	// leaves that state after initialization, its vlist is applied as delta
+	if(bd->bb.hits.size() == 0) return 0;
+	const hit *h0 = &(bd->bb.hits[0]);
+	bool e = (jsetx.size() == bd->regions.size());
+
+	for(int k = 0; k < 2; k++)
+	{
+		for(hit *x = (k == 0 ? fr.h1 : fr.h2); x != NULL; x = x->next)
+		{
+			if(x < h0 || x >= h0 + bd->bb.hits.size()) continue;
+			int i = x - h0;
+			if(d > 0 && jexcl[i] == 0 && e == true) add_junction_nodes(decode_vlist(x->vlist), -1, true);
+			jexcl[i] += d;
+			if(d < 0 && jexcl[i] == 0 && e == true) add_junction_nodes(decode_vlist(x->vlist), 1, true);
+		}
+	}
+	return 0;
+}
+
+int bridger::build_junction_pnodes()
+{
+	pnodes.clear();
+	for(map<vector<int>, int>::iterator it = jnodes.begin(); it != jnodes.end(); it++)
+	{
+		pnodes.push_back(path());
+		path &p = pnodes.back();
+		p.v = it->first;
+		p.score = it->second;
+		bd->build_accumulate_length(p.v, p.acc);
+	}
+	for(int i = 0; i < (int)(bd->regions.size()) - 1; i++)
+	{
+		if(bd->regions[i].rpos != bd->regions[i + 1].lpos) continue;
+		vector<int> s(2);
+		s[0] = i;
+		s[1] = i + 1;
+		if(jnodes.find(s) != jnodes.end()) continue;
+
+		pnodes.push_back(path());
+		path &p = pnodes.back();
+		p.v = s;
+		p.score = 1;
+		bd->build_accumulate_length(p.v, p.acc);
+	}
+	num_path_nodes += pnodes.size();
 	return 0;
 }
 
@@ -431,12 +594,12 @@ int bridger::add_consecutive_path_nodes()
 		region &r2 = bd->regions[i + 1];
 		if(r1.rpos != r2.lpos) continue;
 
-		path p;
+		pnodes.push_back(path());
+		path &p = pnodes.back();
 		p.v.push_back(i + 0);
 		p.v.push_back(i + 1);
 		p.score = 1;
-		p.acc = bd->build_accumulate_length(p.v);
-		pnodes.push_back(p);
+		bd->build_accumulate_length(p.v, p.acc);
 	}
 	return 0;
 }
@@ -468,9 +631,9 @@ int bridger::build_path_nodes(int max_len, vector<fragment> &frags)
 		{
 			vector<int> v = decode_vlist(fr.paths[0].v);
 			if(v.size() <= 1) continue;
-			build_path_nodes(m, v, fr.cnt);		// TODO: consider cnt of fragments
-			hs.insert(fr.h1->hid);
-			hs.insert(fr.h2->hid);
+			build_path_nodes(m, v, fr.cnt);
+			for(hit *x = fr.h1; x != NULL; x = x->next) hs.insert(x->hid);
+			for(hit *x = fr.h2; x != NULL; x = x->next) hs.insert(x->hid);
 		}
 		/*
 		else
@@ -496,13 +659,14 @@ int bridger::build_path_nodes(int max_len, vector<fragment> &frags)
 	pnodes.clear();
 	for(map<vector<int>, int>::iterator it = m.begin(); it != m.end(); it++)
 	{
-		path p;
+		pnodes.push_back(path());
+		path &p = pnodes.back();
 		p.v = it->first;
 		p.score = it->second;
-		p.acc = bd->build_accumulate_length(p.v);
-		pnodes.push_back(p);
+		bd->build_accumulate_length(p.v, p.acc);
 		//adjust_path_score(p);
 	}
+	num_path_nodes += pnodes.size();
 	
 	return 0;
 }
@@ -524,7 +688,6 @@ int bridger::adjust_path_score(path &p)
 
 int bridger::build_path_nodes(map<vector<int>, int> &m, const vector<int> &v, int cnt)
 {
-	cnt = 1;
 	if(v.size() <= 0) return 0;
 	int n = v.size();
 	if(n > max_pnode_length) n = max_pnode_length;
@@ -545,52 +708,79 @@ int bridger::phase_cluster(fcluster &fc)
 {
 	fc.phase.clear();
 	map<int, int> xm;
-	vector<PI> xp = bd->ref_index[fc.v1.front()];
-	for(int j = 0; j < xp.size(); j++)
+	locate_phase(fc.v1, xm);
+	if(xm.size() == 0) return 0;
+
+	map<int, int> ym;
+	locate_phase(fc.v2, ym);
+	for(map<int, int>::iterator it = ym.begin(); it != ym.end(); it++)
 	{
-		int ti = xp[j].first;
-		int ki = xp[j].second;
-		bool b = true;
-		for(int k = 0; k < fc.v1.size(); k++)
-		{
-			if(ki + k >= bd->ref_phase[ti].size() || fc.v1[k] != bd->ref_phase[ti][ki + k])
-			{
-				b = false;
-				break;
-			}
-		}
-		if(b == false) continue;
-		xm.insert(pair<int, int>(ti, ki));
+		int ti = it->first;
+		int ki = it->second;
+		map<int, int>::iterator x = xm.find(ti);
+		if(x == xm.end()) continue;
+		if(ki < x->second + fc.v1.size()) continue;
+
+		vector<int> vv(bd->ref_phase[ti].begin() + x->second, bd->ref_phase[ti].begin() + ki + fc.v2.size());
+		fc.add_phase(vv);
 	}
 
-	vector<PI> yp = bd->ref_index[fc.v2.front()];
-	for(int j = 0; j < yp.size(); j++)
+	return 0;
+}
+
+int bridger::locate_phase(const small_vector<int, 8> &v, map<int, int> &m)
+{
+	// collect (trst, offset) of all ref trsts that contain v consecutively;
+	// ref_phase is increasing, so this holds iff every adjacent pair of v
+	// is adjacent in the trst: intersect the trst lists of these pairs
+	m.clear();
+	if(v.size() == 0) return 0;
+	if(v.size() == 1)
 	{
-		int ti = yp[j].first;
-		int ki = yp[j].second;
-		if(xm.find(ti) == xm.end()) continue;
-		if(ki < xm[ti] + fc.v1.size()) continue;
+		const vector<PI> &xp = bd->ref_index[v[0]];
+		for(int j = 0; j < xp.size(); j++) m.insert(xp[j]);
+		return 0;
+	}
+
+	vector<const vector<int>*> ts;
+	int s = 0;
+	for(int k = 0; k < v.size() - 1; k++)
+	{
+		const map<int, vector<int> > &mn = bd->ref_next[v[k]];
+		map<int, vector<int> >::const_iterator it = mn.find(v[k + 1]);
+		if(it == mn.end()) return 0;
+		ts.push_back(&(it->second));
+		if(it->second.size() < ts[s]->size()) s = ts.size() - 1;
+	}
 
+	for(int j = 0; j < ts[s]->size(); j++)
+	{
+		int ti = ts[s]->at(j);
 		bool b = true;
-		for(int k = 0; k < fc.v2.size(); k++)
+		for(int k = 0; k < ts.size() && b == true; k++)
 		{
-			if(ki + k >= bd->ref_phase[ti].size() || fc.v2[k] != bd->ref_phase[ti][ki + k])
-			{
-				b = false;
-				break;
-			}
+			if(k != s && binary_search(ts[k]->begin(), ts[k]->end(), ti) == false) b = false;
 		}
 		if(b == false) continue;
 
-		vector<int> vv(bd->ref_phase[ti].begin() + xm[ti], bd->ref_phase[ti].begin() + ki + fc.v2.size());
-		fc.add_phase(vv);
+		const vector<int> &u = bd->ref_phase[ti];
+		int ki = lower_bound(u.begin(), u.end(), v[0]) - u.begin();
+		m.insert(PI(ti, ki));
 	}
-
 	return 0;
 }
 
 int bridger::bridge_phased_cluster(fcluster &fc)
 {
+	// path lengths and encodings are shared by all fragments
+	vector< vector<int> > pv(fc.phase.size());
+	vector<int32_t> pl(fc.phase.size());
+	for(int k = 0; k < fc.phase.size(); k++)
+	{
+		pv[k] = encode_vlist(fc.phase[k]);
+		pl[k] = bd->compute_aligned_length(0, 0, fc.phase[k]);
+	}
+
 	for(int i = 0; i < fc.fset.size(); i++)
 	{
 		fragment *fr = fc.fset[i];
@@ -599,9 +789,8 @@ int bridger::bridge_phased_cluster(fcluster &fc)
 		{
 			path p;
 			p.ex1 = p.ex2 = 0;
-			p.v = fc.phase[k];
-			p.length = bd->compute_aligned_length(fr->k1l, fr->k2r, p.v);
-			p.v = encode_vlist(p.v);
+			p.v = pv[k];
+			p.length = pl[k] - fr->k1l - fr->k2r;
 			p.score = 1;
 			if(p.length >= length_low && p.length <= length_high) p.type = 1;
 			else p.type = 2;
@@ -752,16 +941,20 @@ int bridger::bridge_hard_fragments_normal(vector<fcluster> &open)
 			vector< vector<int> > pb = trace_back(j, table);
 			vector< vector<int> > pn;
 			vector<int> ps;
+			vector<int32_t> pl;				// region length of each path
+			vector< vector<int> > pv;		// encoded vlist of each path
 
 			for(int e = 0; e < pb.size(); e++)
 			{
-				vector<int> px = fc.v1;
+				vector<int> px(fc.v1.begin(), fc.v1.end());
 				if(pb[e].size() >= 2) px.insert(px.end(), pb[e].begin() + 1, pb[e].end() - 1);
 				px.insert(px.end(), fc.v2.begin(), fc.v2.end());
 				int s = (int)(min_bridging_score) + 2;
 				if(use_overlap_scoring) s = evaluate_bridging_path(px);
 				pn.push_back(px);
 				ps.push_back(s);
+				pl.push_back(bd->compute_aligned_length(0, 0, px));
+				pv.push_back(encode_vlist(px));
 			}
 
 			/* not used
@@ -791,7 +984,7 @@ int bridger::bridge_hard_fragments_normal(vector<fcluster> &open)
 
 				for(int e = 0; e < pb.size(); e++)
 				{
-					int32_t length = bd->compute_aligned_length(fr->k1l, fr->k2r, pn[e]);
+					int32_t length = pl[e] - fr->k1l - fr->k2r;
 					//printf(" fragment %d length = %d using path %d\n", i, p.length, e);
 
 					// note by Mingfu
@@ -819,7 +1012,7 @@ int bridger::bridge_hard_fragments_normal(vector<fcluster> &open)
 						best_index = e;
 					}
 				}
-				if(best_index >= 0) votes[best_index]++;
+				if(best_index >= 0) votes[best_index] += fr->cnt;
 			}
 
 			int be = 0;
@@ -874,9 +1067,8 @@ int bridger::bridge_hard_fragments_normal(vector<fcluster> &open)
 
 				path p;
 				p.ex1 = p.ex2 = 0;
-				p.v = pn[be];
-				p.length = bd->compute_aligned_length(fr->k1l, fr->k2r, p.v);
-				p.v = encode_vlist(p.v);
+				p.v = pv[be];
+				p.length = pl[be] - fr->k1l - fr->k2r;
 				p.score = ps[be];
 
 				if(p.length >= length_low && p.length <= length_high)
@@ -973,10 +1165,12 @@ int bridger::bridge_hard_fragments_circ(vector<fcluster> &open)
 			vector< vector<int> > pb = trace_back(j, table);
 			vector< vector<int> > pn;
 			vector<int> ps;
+			vector<int32_t> pl;				// region length of each path
+			vector< vector<int> > pv;		// encoded vlist of each path
 
 			for(int e = 0; e < pb.size(); e++)
 			{
-				vector<int> px = fc.v1;
+				vector<int> px(fc.v1.begin(), fc.v1.end());
 				if(pb[e].size() >= 2) px.insert(px.end(), pb[e].begin() + 1, pb[e].end() - 1);
 				px.insert(px.end(), fc.v2.begin(), fc.v2.end());
 				//int s = (int)(min_bridging_score) + 2;
@@ -984,6 +1178,8 @@ int bridger::bridge_hard_fragments_circ(vector<fcluster> &open)
 				if(use_overlap_scoring) s = evaluate_bridging_path(px);
 				pn.push_back(px);
 				ps.push_back(s);
+				pl.push_back(bd->compute_aligned_length(0, 0, px));
+				pv.push_back(encode_vlist(px));
 			}
 
 			for(int i = 0; i < fc.fset.size(); i++)
@@ -994,15 +1190,14 @@ int bridger::bridge_hard_fragments_circ(vector<fcluster> &open)
 				{
 					path p;
 					p.ex1 = p.ex2 = 0;
-					p.v = pn[e];
-					p.length = bd->compute_aligned_length(fr->k1l, fr->k2r, p.v);
-					p.v = encode_vlist(p.v);
+					p.v = pv[e];
+					p.length = pl[e] - fr->k1l - fr->k2r;
 					p.score = ps[e];
 
 					// compare score with fset.size
 					//printf("FSET-SCORE: fset %lu, score %.1lf, read %s, lpos = %d/%d, length %d\n",fc.fset.size(), p.score, fr->h1->qname.c_str(), fr->h1->pos, fr->h2->pos, p.length);
 
-					double fset_score = log(1 + fc.fset.size()) - log(1 + p.score);
+					double fset_score = log(1 + fc.weight()) - log(1 + p.score);
 					if(fset_score > max_fset_score) continue;
 
 					if(p.length >= length_low && p.length <= length_high)
@@ -1094,6 +1289,7 @@ int bridger::dynamic_programming(int k1, int k2, vector< vector<entry> > &table)
 			}
 		}
 
+		num_dp_cells += v.size();
 		sort(v.begin(), v.end(), entry_compare);
 		if(v.size() > dp_solution_size) v.resize(dp_solution_size);
 		table[k] = v;
@@ -1315,34 +1511,50 @@ int bridger::build_overlap_index()
 	for(int k = 0; k < pnodes.size(); k++) psetx[k].clear();
 	for(int k = 0; k < pnodes.size(); k++) psety[k].clear();
 
+	// index every prefix of every path node by a rolling hash, so that
+	// node i only probes the nodes whose prefix matches one of its suffixes;
+	// a hit is confirmed with determine_overlap, keeping the result identical
+	// to comparing all pairs
+	const size_t base = 1000003;
+	vector< pair<size_t, int> > pfx;
+	for(int j = 0; j < pnodes.size(); j++)
+	{
+		const vector<int> &vy = pnodes[j].v;
+		size_t h = 0, b = 1;
+		for(int k = 0; k < vy.size(); k++)
+		{
+			h += (size_t)(vy[k] + 1) * b;
+			b *= base;
+			pfx.push_back(pair<size_t, int>(h, j));
+		}
+	}
+	sort(pfx.begin(), pfx.end());
+
 	int cnt1 = 0;
 	for(int i = 0; i < pnodes.size(); i++)
 	{
 		const vector<int> &vx = pnodes[i].v;
-		for(int j = i + 1; j < pnodes.size(); j++)
+		size_t h = 0;
+		for(int k = (int)(vx.size()) - 1; k >= 0; k--)
 		{
-			const vector<int> &vy = pnodes[j].v;
-
-			PI p;
-			int t = determine_overlap(vx, vy, p);
-			if(t != 1) continue;
-			assert(p.first >= 0 && p.first < vx.size());
-			assert(p.second >= 0 && p.second < vy.size());
-
-			//int32_t len2 = pnodes[j].acc.back() - pnodes[j].acc[p.second];
-			//int32_t len1 = (p.first == 0) ? 0 : pnodes[i].acc[p.first - 1];
+			h = h * base + (size_t)(vx[k] + 1);
+			vector< pair<size_t, int> >::iterator it = lower_bound(pfx.begin(), pfx.end(), pair<size_t, int>(h, i + 1));
+			for(; it != pfx.end() && it->first == h; it++)
+			{
+				int j = it->second;
+				if(psetx[i].find(j) != psetx[i].end()) continue;
 
-			// pset1 & 2 are full
-			//pset1[i].insert(pair<int, int>(j, p.second));
-			//pset2[j].insert(pair<int, int>(i, p.first));
+				const vector<int> &vy = pnodes[j].v;
+				PI p;
+				int t = determine_overlap(vx, vy, p);
+				if(t != 1) continue;
+				assert(p.first >= 0 && p.first < vx.size());
+				assert(p.second >= 0 && p.second < vy.size());
 
-			// psetx & y are not full
-			// consider only (1,2,3) -> (2,3,4)
-			//if(p.first == 0) continue;
-			//if(p.second == vy.size() - 1) continue;
-			psetx[i].insert(pair<int, int>(j, p.second));
-			psety[j].insert(pair<int, int>(i, p.first));
-			cnt1++;
+				psetx[i].insert(pair<int, int>(j, p.second));
+				psety[j].insert(pair<int, int>(i, p.first));
+				cnt1++;
+			}
 		}
 	}
 
@@ -1778,7 +1990,7 @@ int bridger::pick_bridge_path(vector<fragment> &frags)
 	//printf("1.5*length_high = %lf\n",1.5*length_high);
 	for(int k = 0; k < frags.size(); k++)
 	{
-		all_count++;
+		all_count += frags[k].cnt;
 
 		fragment &fr = frags[k];
 
@@ -1890,7 +2102,7 @@ int bridger::pick_bridge_path(vector<fragment> &frags)
 
 			for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 			{
-				region r(lower(it->first), upper(it->first), '.', '.');
+				region_span r(lower(it->first), upper(it->first));
 				p1->merged_regions.push_back(r);
 			}
 			
@@ -1984,7 +2196,7 @@ int bridger::pick_bridge_path(vector<fragment> &frags)
 			{
 				for(int j=1;j<p1.path_regions.size()-1;j++) //exclude first and last exon for gapped checking
 				{
-					region r = p1.path_regions[j];
+					const region_span &r = p1.path_regions[j];
 					if(r.gapped == true)
 					{
 						remove_list.push_back(p1);
@@ -2304,10 +2516,10 @@ int bridger::pick_bridge_path(vector<fragment> &frags)
 				// later on we can take the #counts in reference into account
 
 				best_path = ref_paths_map.begin()->second.first;
-				only_ref_count++;
+				only_ref_count += fr.cnt;
 
-				if(ref_paths_map.size() == 1) single_ref_count++;
-				else if(ref_paths_map.size() > 1) multi_ref_count++;
+				if(ref_paths_map.size() == 1) single_ref_count += fr.cnt;
+				else if(ref_paths_map.size() > 1) multi_ref_count += fr.cnt;
 
 				//discard this frag if comes to only ref
 				// fr.set_bridged(false);
@@ -47,6 +47,14 @@ public:
 	int32_t length_low;	//DISTRBN OF FRGAMNET length 0
 	int32_t length_high; //DISTRBN OF FRGAMNET length 10000
 
+	map<vector<int>, int> jnodes;	// path nodes (length <= 2) of the junction graph with support
+	vector<fragment> *jfrags;		// fragments the junction graph was last synced with
+	vector<hit*> jheads;			// h1 of each fragment in jfrags, to detect a different vector
+	vector< vector<int> > jpaths;	// bridging path each fragment contributes, empty if none
+	vector<int> jexcl;				// per hit of bb: number of contributing fragments containing it
+	int64_t num_path_nodes;			// number of path nodes built, for profiling
+	int64_t num_dp_cells;			// number of entries created by dynamic programming, for profiling
+
 public:
 	int bridge_normal_fragments();
 	int bridge_circ_fragments();
@@ -60,11 +68,19 @@ public:
 
 	int bridge_phased_fragments(vector<fcluster> &fclusters);
 	int phase_cluster(fcluster &fc);
+	int locate_phase(const small_vector<int, 8> &v, map<int, int> &m);
 	int bridge_phased_cluster(fcluster &fc);
 
 	int remove_tiny_boundary(vector<fragment> &frags);
 
 	int build_junction_graph(vector<fragment> &frags);
+	int init_junction_graph(vector<fragment> &frags);
+	int sync_junction_graph(vector<fragment> &frags);
+	int get_junction_path(const fragment &fr, vector<int> &v);
+	int add_junction_nodes(const vector<int> &v, int cnt, bool e);
+	int set_junction_edge(int x, int y);
+	int set_hit_exclusion(const fragment &fr, int d);
+	int build_junction_pnodes();
 	int bridge_hard_fragments_normal(vector<fcluster> &open);
 	int bridge_hard_fragments_circ(vector<fcluster> &open);
 	int dynamic_programming(int k1, int k2, vector< vector<entry> > &table);
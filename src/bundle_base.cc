@@ -8,9 +8,30 @@ See LICENSE for licensing.
 #include <cstdio>
 #include <cmath>
 #include <climits>
+#include <algorithm>
 
 #include "bundle_base.h"
 
+// boundary soft clip that may pass min_soft_clip_len once tiny boundaries are removed
+static inline bool has_long_soft_clip(const hit &ht)
+{
+	const pair<char, int32_t> &c1 = ht.cigar_vector.front();
+	const pair<char, int32_t> &c2 = ht.cigar_vector.back();
+	if(c1.first == 'S' && c1.second + flank_tiny_length >= min_soft_clip_len) return true;
+	if(c2.first == 'S' && c2.second + flank_tiny_length >= min_soft_clip_len) return true;
+	return false;
+}
+
+// map a read-name hash to a uniform value in [0, 1)
+static inline double qhash_unit(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	x = x ^ (x >> 31);
+	return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
 bundle_base::bundle_base()
 {
 	tid = -1;
@@ -19,6 +40,14 @@ bundle_base::bundle_base()
 	rpos = 0;
 	strand = '.';
 	fake_hits.clear();
+	num_suppl_hits = 0;
+	num_sa_hits = 0;
+	num_soft_clip_hits = 0;
+	num_spliced_hits = 0;
+	num_carried_hits = 0;
+	carried_lpos = 1 << 30;
+	carried_rpos = 0;
+	sample_rate = 1;
 }
 
 bundle_base::~bundle_base()
@@ -33,15 +62,24 @@ int bundle_base::add_hit(const hit &ht)
 	if(ht.pos < lpos) lpos = ht.pos;
 	if(ht.rpos > rpos) rpos = ht.rpos;
 
-	// try to include more paired-end reads
+	// try to include more paired-end reads; with split_bundles, bundles
+	// follow coverage only and partners across a cut go through the mate stash
 	int32_t p = ht.rpos;
-	if(ht.mpos > ht.rpos && ht.mpos <= ht.rpos + 1000000) p = ht.mpos;
+	if(split_bundles == false && ht.mpos > ht.rpos && ht.mpos <= ht.rpos + 1000000) p = ht.mpos;
 	if(p > rpos) rpos = p;
 
 	//try to include supplementary reads
-	if(ht.supple_pos != 0 && ht.supple_pos > ht.rpos && ht.supple_pos <= ht.rpos + 1000000) p = ht.supple_pos;
+	if(split_bundles == false && ht.supple_pos != 0 && ht.supple_pos > ht.rpos && ht.supple_pos <= ht.rpos + 1000000) p = ht.supple_pos;
 	if(p > rpos) rpos = p;
 
+	// collect back-splice evidence; soft clips may later grow by
+	// at most flank_tiny_length when tiny boundaries are removed
+	if((ht.flag & 0x800) >= 1) num_suppl_hits++;
+	if(ht.sa != "") num_sa_hits++;
+	if(ht.spos.size() >= 1) num_spliced_hits++;
+
+	if(has_long_soft_clip(ht) == true) num_soft_clip_hits++;
+
 	// set tid
 	if(tid == -1) tid = ht.tid;
 	assert(tid == ht.tid);
@@ -83,6 +121,144 @@ int bundle_base::add_hit(const hit &ht)
 	return 0;
 }
 
+bool bundle_base::has_bsj_evidence() const
+{
+	// circ fragments come from supplementary hits, or from
+	// soft clips rescued in get_more_chimeric (requires fasta)
+	if(num_suppl_hits >= 1) return true;
+	if(num_sa_hits >= 1) return true;
+	if(fasta_file != "" && num_soft_clip_hits >= 1) return true;
+	return false;
+}
+
+double bundle_base::estimate_cost() const
+{
+	// linear model over statistics known before the bundle is built;
+	// supplementary hits drive circ fragments and thus bridging
+	double c = 0;
+	c += cost_weight_hit * hits.size();
+	c += cost_weight_spliced * num_spliced_hits;
+	c += cost_weight_suppl * (num_suppl_hits + num_sa_hits);
+	if(rpos > lpos) c += cost_weight_span * (rpos - lpos);
+	return c;
+}
+
+int bundle_base::add_carried_hit(const hit &ht)
+{
+	// ht comes from an earlier bundle and lies left of all hits here;
+	// it does not widen [lpos, rpos), which follows this bundle's own
+	// coverage; span_lpos and span_rpos include it
+	int32_t l = lpos;
+	int32_t r = rpos;
+	add_hit(ht);
+	lpos = l;
+	rpos = r;
+
+	hits.back().is_carried = true;
+	if(ht.pos < carried_lpos) carried_lpos = ht.pos;
+	if(ht.rpos > carried_rpos) carried_rpos = ht.rpos;
+	num_carried_hits++;
+	return 0;
+}
+
+int bundle_base::add_carried_splices(const vector<hit> &v)
+{
+	// junction evidence around the carried hits, which the unsplit bundle
+	// would have seen; hits that were carried themselves are skipped
+	vector<int> s;
+	for(int i = 0; i < hits.size(); i++)
+	{
+		if(hits[i].is_carried == true) s.push_back(hits[i].hid);
+	}
+	sort(s.begin(), s.end());
+
+	for(int i = 0; i < v.size(); i++)
+	{
+		if(binary_search(s.begin(), s.end(), v[i].hid) == true) continue;
+		carried_splices.push_back(v[i]);
+		if(v[i].pos < carried_lpos) carried_lpos = v[i].pos;
+		if(v[i].rpos > carried_rpos) carried_rpos = v[i].rpos;
+	}
+	return 0;
+}
+
+int32_t bundle_base::span_lpos() const
+{
+	// extent that regions and reference transcripts of the bundle cover
+	if(num_carried_hits >= 1 && carried_lpos < lpos) return carried_lpos;
+	return lpos;
+}
+
+int32_t bundle_base::span_rpos() const
+{
+	if(num_carried_hits >= 1 && carried_rpos > rpos) return carried_rpos;
+	return rpos;
+}
+
+int bundle_base::sort_hits()
+{
+	// restore input order (hids are assigned in coordinate order)
+	if(num_carried_hits == 0) return 0;
+	stable_sort(hits.begin(), hits.end(), hit_compare_by_hid);
+	return 0;
+}
+
+int bundle_base::downsample(int budget)
+{
+	if(budget <= 0 || hits.size() <= budget) return 0;
+
+	// reads with any supplementary, SA or long soft-clip hit are kept in full
+	vector<size_t> chimeric;
+	for(int i = 0; i < hits.size(); i++)
+	{
+		const hit &h = hits[i];
+		if((h.flag & 0x800) >= 1 || h.sa != "" || has_long_soft_clip(h) == true) chimeric.push_back(h.qhash);
+	}
+	sort(chimeric.begin(), chimeric.end());
+
+	int nc = 0;
+	vector<bool> keep(hits.size(), false);
+	for(int i = 0; i < hits.size(); i++)
+	{
+		keep[i] = binary_search(chimeric.begin(), chimeric.end(), hits[i].qhash);
+		if(keep[i] == true) nc++;
+	}
+
+	// the rest is sampled uniformly, so coverage scales by the same rate;
+	// deciding by read name keeps mates together and runs reproducible
+	double rate = 0;
+	if(budget > nc) rate = (budget - nc) * 1.0 / (hits.size() - nc);
+	for(int i = 0; i < hits.size(); i++)
+	{
+		if(keep[i] == false && qhash_unit(hits[i].qhash) < rate) keep[i] = true;
+	}
+
+	// rebuild the bundle from the kept hits
+	vector<hit> v;
+	v.swap(hits);
+	vector<hit> sp;
+	sp.swap(carried_splices);
+	string c = chrm;
+	int32_t t = tid;
+	clear();
+	chrm = c;
+	for(int i = 0; i < v.size(); i++)
+	{
+		if(keep[i] == false) continue;
+		if(v[i].is_carried == true) add_carried_hit(v[i]);
+		else add_hit(v[i]);
+	}
+	add_carried_splices(sp);
+	tid = t;
+	sample_rate = rate;
+	return 0;
+}
+
+bool hit_compare_by_hid(const hit &x, const hit &y)
+{
+	return x.hid < y.hid;
+}
+
 bool bundle_base::overlap(const hit &ht) const
 {
 	if(mmap.find(ROI(ht.pos, ht.pos + 1)) != mmap.end()) return true;
@@ -100,6 +276,15 @@ int bundle_base::clear()
 	hits.clear();
 	mmap.clear();
 	imap.clear();
+	num_suppl_hits = 0;
+	num_sa_hits = 0;
+	num_soft_clip_hits = 0;
+	num_spliced_hits = 0;
+	num_carried_hits = 0;
+	carried_lpos = 1 << 30;
+	carried_rpos = 0;
+	carried_splices.clear();
+	sample_rate = 1;
 	return 0;
 }
 
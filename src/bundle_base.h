@@ -34,10 +34,31 @@ public:
 	split_interval_map mmap;		// matched interval map
 	split_interval_map imap;		// indel interval map
 
+	// back-splice evidence summary, accumulated in add_hit
+	int num_suppl_hits;				// hits flagged as supplementary (0x800)
+	int num_sa_hits;				// hits carrying an SA tag
+	int num_soft_clip_hits;			// hits with a boundary soft clip that may pass min_soft_clip_len
+	int num_spliced_hits;			// hits with at least one splice position
+	int num_carried_hits;			// hits handed over from an earlier bundle by the mate stash
+	int32_t carried_lpos;			// leftmost boundary of carried hits and splices, not part of [lpos, rpos)
+	int32_t carried_rpos;			// rightmost boundary of carried hits and splices
+	vector<hit> carried_splices;	// spliced hits of earlier bundles near the carried hits, used for junctions only
+	double sample_rate;				// fraction of non-chimeric reads kept by downsample, 1 if not downsampled
+
 public:
 	int add_hit(const hit &ht);
 	bool overlap(const hit &ht) const;
+	bool has_bsj_evidence() const;
+	double estimate_cost() const;
+	int add_carried_hit(const hit &ht);
+	int add_carried_splices(const vector<hit> &v);
+	int32_t span_lpos() const;
+	int32_t span_rpos() const;
+	int sort_hits();
+	int downsample(int budget);
 	int clear();
 };
 
+bool hit_compare_by_hid(const hit &x, const hit &y);
+
 #endif
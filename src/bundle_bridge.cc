@@ -11,6 +11,7 @@ See LICENSE for licensing.
 #include <cassert>
 #include <cstdio>
 #include <map>
+#include <unordered_map>
 #include <iomanip>
 #include <fstream>
 
@@ -21,7 +22,7 @@ See LICENSE for licensing.
 #include "bridger.h"
 
 bundle_bridge::bundle_bridge(bundle_base &b, reference &r)
-	: bb(b), ref(r)
+	: bb(b), ref(r), prof(NULL)
 {
 	circ_trsts.clear(); // emptying before storing circRNAs
 	circ_trsts_HS.clear();
@@ -33,12 +34,13 @@ bundle_bridge::bundle_bridge(bundle_base &b, reference &r)
 	multi_ref_chosen_count = 0;
 
 	compute_strand();
-	ref_trsts = ref.get_overlapped_transcripts(bb.chrm, bb.strand, bb.lpos, bb.rpos);
+	intern_qnames();
+	ref_trsts = ref.get_overlapped_transcripts(bb.chrm, bb.strand, bb.span_lpos(), bb.span_rpos());
 	//build(RO_reads_map, fai);
 }
 
-bundle_bridge::bundle_bridge(bundle_base &b, reference &r, map <string, int> RO_reads_map, faidx_t *fai)
-	: bb(b), ref(r)
+bundle_bridge::bundle_bridge(bundle_base &b, reference &r, const RO_index &ro_index, faidx_t *fai, bundle_profile *prof)
+	: bb(b), ref(r), prof(prof)
 {
 	circ_trsts.clear(); // emptying before storing circRNAs
 	circ_trsts_HS.clear();
@@ -50,8 +52,9 @@ bundle_bridge::bundle_bridge(bundle_base &b, reference &r, map <string, int> RO_
 	multi_ref_chosen_count = 0;
 
 	compute_strand();
-	ref_trsts = ref.get_overlapped_transcripts(bb.chrm, bb.strand, bb.lpos, bb.rpos);
-	build(RO_reads_map, fai);
+	intern_qnames();
+	ref_trsts = ref.get_overlapped_transcripts(bb.chrm, bb.strand, bb.span_lpos(), bb.span_rpos());
+	build(ro_index, fai);
 }
 
 bundle_bridge::~bundle_bridge()
@@ -85,7 +88,7 @@ int bundle_bridge::compute_strand()
 	return 0;
 }
 
-int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
+int bundle_bridge::build(const RO_index &ro_index, faidx_t *_fai)
 {
 	fai = _fai;
 
@@ -100,25 +103,42 @@ int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
 		}
 	}*/
 
-	set_hits_RO_parameter(RO_reads_map);
+	stage_timer tt(prof, PROFILE_TOTAL);
 
-	build_supplementaries();
+	set_hits_RO_parameter(ro_index);
+
+	{
+		stage_timer t(prof, PROFILE_SUPPLEMENTARIES);
+		build_supplementaries();
+	}
 	set_chimeric_cigar_positions(); //setting h.first_pos/second_pos etc for getting back splice positions using cigars 
-	build_junctions();
-	extend_junctions();
+	{
+		stage_timer t(prof, PROFILE_JUNCTIONS);
+		build_junctions();
+		extend_junctions();
+	}
 
-	build_regions();
-	build_partial_exons();
+	{
+		stage_timer t(prof, PROFILE_REGIONS);
+		build_regions();
+		build_partial_exons();
+	}
 
 	align_hits_transcripts();
-	index_references();
+	if(bsj_only == false) index_references();
 
 	//printf("Called from bundle_bridge\n");
-	build_fragments(); //builds fragment from h1p to h2
+	{
+		stage_timer t(prof, PROFILE_FRAGMENTS);
+		build_fragments(); //builds fragment from h1p to h2
+	}
 	//printf("\n");
 
 	fix_alignment_boundaries();
-	build_circ_fragments(); //will build fragment from h2 to h1s, added by Tasfia
+	{
+		stage_timer t(prof, PROFILE_CIRC_FRAGMENTS);
+		build_circ_fragments(); //will build fragment from h2 to h1s, added by Tasfia
+	}
 
 	//group_fragments();
 
@@ -134,6 +154,7 @@ int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
 	//find more chimeric reads from soft clip reads only if refrence genome parameter is given.
 	if(fasta_file != "")
 	{
+		stage_timer t(prof, PROFILE_MORE_CHIMERIC);
 		get_more_chimeric();
 	}
 
@@ -141,7 +162,10 @@ int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
 	align_fake_hits();
 
 	//create fragments from fake hits
-	create_fake_fragments();
+	{
+		stage_timer t(prof, PROFILE_FAKE_FRAGMENTS);
+		create_fake_fragments();
+	}
 
 	// call remove_tiny_boundary for the newly 
 	// created (fake) hits here
@@ -149,17 +173,48 @@ int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
 
 	set_circ_fragment_lengths();
 
+	// one fragment per UMI molecule
+	if(umi_dedup == true) dedup_umi_fragments();
+
+	// bsj-only mode: pair fragments and count back-splice junctions, no bridging
+	if(bsj_only == true)
+	{
+		extract_circ_fragment_pairs();
+		collect_bsjs();
+		set_profile_counters(NULL);
+		return 0;
+	}
+
+	// identical fragments are bridged once, then results are copied back
+	vector<fragment> all;
+	vector<int> cls;
+
 	bridger bdg(this);
-	bdg.bridge_normal_fragments();
-	bdg.bridge_circ_fragments();
+	{
+		stage_timer t(prof, PROFILE_BRIDGE_NORMAL);
+		if(collapse_duplicate_fragments == true) collapse_fragments(fragments, circ_fragments, all, cls);
+		bdg.bridge_normal_fragments();
+		if(collapse_duplicate_fragments == true) expand_fragments(fragments, all, cls);
+	}
+
+	{
+		stage_timer t(prof, PROFILE_BRIDGE_CIRC);
+		if(collapse_duplicate_fragments == true) collapse_fragments(circ_fragments, fragments, all, cls);
+		bdg.bridge_circ_fragments();
+		if(collapse_duplicate_fragments == true) expand_fragments(circ_fragments, all, cls);
+	}
 
 	//extract_RO_circRNA();
 	//extract_HS_frags_circRNA();
 
-	extract_circ_fragment_pairs();
-	//print_circ_fragment_pairs();
-	join_circ_fragment_pairs(bdg.length_high);
+	{
+		stage_timer t(prof, PROFILE_JOIN_PAIRS);
+		extract_circ_fragment_pairs();
+		//print_circ_fragment_pairs();
+		join_circ_fragment_pairs(bdg.length_high);
+	}
 	//print_circRNAs();
+	set_profile_counters(&bdg);
 
 	//printf("fragments vector size after = %zu\n",fragments.size());
 
@@ -174,15 +229,34 @@ int bundle_bridge::build(map <string, int> RO_reads_map, faidx_t *_fai)
 	return 0;
 }
 
-int bundle_bridge::set_hits_RO_parameter(map <string, int> RO_reads_map)
+int bundle_bridge::set_profile_counters(const bridger *bdg)
 {
-	for(int i=0;i<bb.hits.size();i++)
+	if(prof == NULL) return 0;
+	prof->chrm = bb.chrm;
+	prof->lpos = bb.lpos;
+	prof->rpos = bb.rpos;
+	prof->strand = bb.strand;
+	prof->hits = bb.hits.size();
+	prof->junctions = junctions.size();
+	prof->regions = regions.size();
+	prof->fragments = fragments.size();
+	prof->circ_fragments = circ_fragments.size();
+	if(bdg == NULL) return 0;
+	prof->path_nodes = bdg->num_path_nodes;
+	prof->dp_cells = bdg->num_dp_cells;
+	return 0;
+}
+
+int bundle_bridge::set_hits_RO_parameter(const RO_index &ro_index)
+{
+	// look up the partition of this chrm once, then probe by qhash
+	const RO_chrm_index *ci = ro_index.get(bb.chrm);
+
+	for(int i=0;i<bb.hits.size() && ci != NULL;i++)
 	{
 		hit *curr_hit = &bb.hits[i];
-		string hash = "";
-		hash = hash + bb.chrm + ":" + curr_hit->qname;
 
-		if(RO_reads_map.find(hash) != RO_reads_map.end())
+		if(ci->contains(curr_hit->qhash, curr_hit->qname))
 		{
 			//hit is a RO read
 			curr_hit->is_reverse_overlap = true;
@@ -203,6 +277,19 @@ int bundle_bridge::set_hits_RO_parameter(map <string, int> RO_reads_map)
 	return 0;
 }
 
+int bundle_bridge::intern_qnames()
+{
+	// assign each distinct read name a dense id, so that later
+	// pairing of hits compares integers instead of strings
+	qtable.clear();
+	qtable.reserve(bb.hits.size());
+	for(int i = 0; i < bb.hits.size(); i++)
+	{
+		bb.hits[i].qid = qtable.intern(bb.hits[i]);
+	}
+	return 0;
+}
+
 int bundle_bridge::get_frags_with_HS_on_both_sides()
 {
 	HS_both_side_reads.clear();
@@ -1013,6 +1100,7 @@ int bundle_bridge::create_fake_supple(int fr_index, fragment &fr, int32_t soft_l
 	new_hit.tid = fr.h1->tid;
 	new_hit.qname = fr.h1->qname;
 	new_hit.qhash = fr.h1->qhash;
+	new_hit.qid = fr.h1->qid;
 
 	new_hit.pos = pos1;
 	new_hit.rpos = pos2;
@@ -1083,7 +1171,7 @@ int bundle_bridge::build_supplementaries()
 
         // do not use hi; as long as qname, pos and isize are identical
         // add 0x40 and 0x80
-        int k = (h.qhash % max_index + (h.flag & 0x40) + (h.flag & 0x80)) % max_index;
+        int k = (h.qid % max_index + (h.flag & 0x40) + (h.flag & 0x80)) % max_index;
         vv[k].push_back(i);
         //printf("Adding supple\n");
     }
@@ -1099,7 +1187,7 @@ int bundle_bridge::build_supplementaries()
         //if(h.vlist.size() == 0) continue;
         if((h.flag & 0x800) >= 1) continue;       // skip supplemetary
 
-        int k = (h.qhash % max_index + (h.flag & 0x40) + (h.flag & 0x80)) % max_index;
+        int k = (h.qid % max_index + (h.flag & 0x40) + (h.flag & 0x80)) % max_index;
 
         for(int j = 0; j < vv[k].size(); j++)
         {
@@ -1109,8 +1197,7 @@ int bundle_bridge::build_supplementaries()
             //if(z.paired == true) continue;
             //if(z.pos != h.mpos) continue;
             //if(z.isize + h.isize != 0) continue;
-            //if(z.qhash != h.qhash) continue;
-            if(z.qname != h.qname) continue;
+            if(z.qid != h.qid) continue;
 
             // TODO check 0x40 and 0x80 are the same
             if(((z.flag & 0x40) != (h.flag & 0x40)) || ((z.flag & 0x80) != (h.flag & 0x80))) continue;
@@ -1322,9 +1409,11 @@ int bundle_bridge::build_junctions()
 {
 	int min_max_boundary_quality = min_mapping_quality; //building a list of all splice pos and the hit index that includes the splice pos
 	map< int64_t, vector<int> > m; // map of spos against vector of hits indices
-	for(int i = 0; i < bb.hits.size(); i++)
+	int n = bb.hits.size();
+	for(int i = 0; i < n + bb.carried_splices.size(); i++)
 	{
-		vector<int64_t> v = bb.hits[i].spos;
+		// spliced hits carried from an earlier bundle follow bb.hits
+		const small_vector<int64_t, 2> &v = (i < n ? bb.hits[i].spos : bb.carried_splices[i - n].spos);
 		//printf("Spos size: %d\n", v.size());
 
 		if(v.size() == 0) continue;
@@ -1364,7 +1453,7 @@ int bundle_bridge::build_junctions()
 		int nm = 0;
 		for(int k = 0; k < v.size(); k++)
 		{
-			hit &h = bb.hits[v[k]];
+			hit &h = (v[k] < n ? bb.hits[v[k]] : bb.carried_splices[v[k] - n]);
 			nm += h.nm;
 			if(h.xs == '.') s0++;
 			if(h.xs == '+') s1++;
@@ -1510,8 +1599,9 @@ int bundle_bridge::extend_junctions()
 int bundle_bridge::build_regions()
 {
 	MPI s;
-	s.insert(PI(bb.lpos, START_BOUNDARY));
-	s.insert(PI(bb.rpos, END_BOUNDARY));
+	s.insert(PI(bb.span_lpos(), START_BOUNDARY));
+	s.insert(PI(bb.span_rpos(), END_BOUNDARY));
+
 	for(int i = 0; i < junctions.size(); i++)
 	{
 		junction &jc = junctions[i];
@@ -1546,6 +1636,10 @@ int bundle_bridge::build_regions()
 		regions.push_back(rr);
 	}
 
+	// regions are contiguous, so their boundaries form one sorted array
+	bounds.clear();
+	for(int k = 0; k < v.size(); k++) bounds.push_back(v[k].first);
+
 	return 0;
 }
 
@@ -1579,24 +1673,18 @@ int bundle_bridge::build_partial_exons()
 
 int bundle_bridge::align_hits_transcripts()
 {
-	map<int32_t, int> m;
-	for(int k = 0; k < regions.size(); k++)
-	{
-		if(k >= 1) assert(regions[k - 1].rpos == regions[k].lpos);
-		m.insert(pair<int32_t, int>(regions[k].lpos, k));
-	}
-
+	assert(bounds.size() == regions.size() + 1 || regions.size() == 0);
 	for(int i = 0; i < bb.hits.size(); i++)
 	{
-		align_hit(m, bb.hits[i], bb.hits[i].vlist);
-		bb.hits[i].vlist = encode_vlist(bb.hits[i].vlist);
+		align_hit(bb.hits[i], dv1);
+		bb.hits[i].vlist = encode_vlist(dv1);
 		//remove_tiny_boundary(bb.hits[i]);
 	}
 
 	ref_phase.resize(ref_trsts.size());
 	for(int i = 0; i < ref_trsts.size(); i++)
 	{
-		align_transcript(m, ref_trsts[i], ref_phase[i]);
+		align_transcript(ref_trsts[i], ref_phase[i]);
 	}
 
 	return 0;
@@ -1604,17 +1692,10 @@ int bundle_bridge::align_hits_transcripts()
 
 int bundle_bridge::align_fake_hits()
 {
-	map<int32_t, int> m;
-	for(int k = 0; k < regions.size(); k++)
-	{
-		if(k >= 1) assert(regions[k - 1].rpos == regions[k].lpos);
-		m.insert(pair<int32_t, int>(regions[k].lpos, k));
-	}
-
 	for(int i = 0; i < bb.fake_hits.size(); i++)
 	{
-		align_hit(m, bb.fake_hits[i], bb.fake_hits[i].vlist);
-		bb.fake_hits[i].vlist = encode_vlist(bb.fake_hits[i].vlist);
+		align_hit(bb.fake_hits[i], dv1);
+		bb.fake_hits[i].vlist = encode_vlist(dv1);
 	}
 
 	/*if(bb.fake_hits.size() > 0)
@@ -1685,14 +1766,13 @@ int bundle_bridge::create_fake_fragments()
 
 	//making above extraction more efficient
 
-	map<string, int> circ_map;
+	// index fake hits by interned qname id; keep the first one of each name
+	vector<int> circ_map(qtable.size(), -1);
 	for(int j=0;j<bb.fake_hits.size();j++)
 	{
 		hit &z = bb.fake_hits[j];
-		if(circ_map.find(z.qname) == circ_map.end())
-		{
-			circ_map.insert(make_pair(z.qname, j));
-		}
+		if(z.qid < 0) continue;
+		if(circ_map[z.qid] == -1) circ_map[z.qid] = j;
 	}
 
 	for(int k=0; k<fragments.size(); k++)
@@ -1700,15 +1780,15 @@ int bundle_bridge::create_fake_fragments()
 		fragment &fr = fragments[k];
 		if(fr.fake_hit_index == -1) continue;
 
-		if(circ_map.find(fr.h1->qname) == circ_map.end()) continue;
+		if(fr.h1->qid < 0 || circ_map[fr.h1->qid] == -1) continue;
 
-		int j = circ_map[fr.h1->qname];
+		int j = circ_map[fr.h1->qid];
 		hit &z = bb.fake_hits[j];
 
 		if(z.vlist.size() == 0) continue;
 		if(z.fake_hit_index == -1) continue;
 
-		assert(fr.h1->qname == z.qname);
+		assert(fr.h1->qid == z.qid);
 
 		if(fr.fake_hit_index == j && z.fake_hit_index == k)
 		{
@@ -1806,8 +1886,10 @@ int bundle_bridge::set_fragment_length(fragment &fr)
 		return 0;
 	}
 
-	vector<int> v1 = decode_vlist(fr.h1->vlist);
-	vector<int> v2 = decode_vlist(fr.h2->vlist);
+	vector<int> &v1 = dv1;
+	vector<int> &v2 = dv2;
+	decode_vlist(fr.h1->vlist, v1);
+	decode_vlist(fr.h2->vlist, v2);
 	fr.k1l = fr.h1->pos - regions[v1.front()].lpos;
 	fr.k1r = regions[v1.back()].rpos - fr.h1->rpos;
 	fr.k2l = fr.h2->pos - regions[v2.front()].lpos;
@@ -1844,7 +1926,7 @@ int bundle_bridge::set_fragment_length(fragment &fr)
 	return 0;
 }
 
-int bundle_bridge::align_hit(const map<int32_t, int> &m, const hit &h, vector<int> &vv)
+int bundle_bridge::align_hit(const hit &h, vector<int> &vv)
 {
 	vv.clear();
 	vector<int64_t> v;
@@ -1857,28 +1939,23 @@ int bundle_bridge::align_hit(const map<int32_t, int> &m, const hit &h, vector<in
 	int32_t p1 = high32(v.front());
 	int32_t p2 = low32(v.back());
 
+	// intervals are sorted, so each lookup resumes from the previous one
 	sp[0].first = locate_region(p1);
-	for(int k = 1; k < v.size(); k++)
-	{
-		p1 = high32(v[k]);
-
-		map<int32_t, int>::const_iterator it = m.find(p1);
-
-		//assert(it != m.end());
-		if(it == m.end()) return 0;
-		sp[k].first = it->second;
-	}
-
-	sp[sp.size() - 1].second = locate_region(p2 - 1);
+	int lo = sp[0].first < 0 ? 0 : sp[0].first;
 	for(int k = 0; k < v.size() - 1; k++)
 	{
 		p2 = low32(v[k]);
-		map<int32_t, int>::const_iterator it = m.find(p2);
-		
-		//assert(it != m.end());
-		if(it == m.end()) return 0;
-		sp[k].second = it->second - 1; 
+		int x = locate_boundary(p2, lo);
+		if(x >= regions.size() || bounds[x] != p2) return 0;
+		sp[k].second = x - 1;
+
+		p1 = high32(v[k + 1]);
+		int y = locate_boundary(p1, x);
+		if(y >= regions.size() || bounds[y] != p1) return 0;
+		sp[k + 1].first = y;
+		lo = y;
 	}
+	sp[sp.size() - 1].second = locate_region(low32(v.back()) - 1);
 
 	for(int k = 0; k < sp.size(); k++)
 	{
@@ -1890,14 +1967,14 @@ int bundle_bridge::align_hit(const map<int32_t, int> &m, const hit &h, vector<in
 	return 0;
 }
 
-int bundle_bridge::align_transcript(const map<int32_t, int> &m, const transcript &t, vector<int> &vv)
+int bundle_bridge::align_transcript(const transcript &t, vector<int> &vv)
 {
 	vv.clear();
 	int k1 = -1;
 	int k2 = -1;
 	for(int k = 0; k < t.exons.size(); k++)
 	{
-		if(t.exons[k].second > bb.lpos)
+		if(t.exons[k].second > bb.span_lpos())
 		{
 			k1 = k;
 			break;
@@ -1905,7 +1982,7 @@ int bundle_bridge::align_transcript(const map<int32_t, int> &m, const transcript
 	}
 	for(int k = t.exons.size() - 1; k >= 0; k--)
 	{
-		if(t.exons[k].first < bb.rpos)
+		if(t.exons[k].first < bb.span_rpos())
 		{
 			k2 = k;
 			break;
@@ -1918,25 +1995,24 @@ int bundle_bridge::align_transcript(const map<int32_t, int> &m, const transcript
 	vector<PI> sp;
 	sp.resize(k2 + 1);
 
-	int32_t p1 = t.exons[k1].first > bb.lpos ? t.exons[k1].first : bb.lpos;
-	int32_t p2 = t.exons[k2].second < bb.rpos ? t.exons[k2].second : bb.rpos;
+	int32_t p1 = t.exons[k1].first > bb.span_lpos() ? t.exons[k1].first : bb.span_lpos();
+	int32_t p2 = t.exons[k2].second < bb.span_rpos() ? t.exons[k2].second : bb.span_rpos();
 
 	sp[k1].first = locate_region(p1);
-	for(int k = k1 + 1; k <= k2; k++)
-	{
-		p1 = t.exons[k].first;
-		map<int32_t, int>::const_iterator it = m.find(p1);
-		assert(it != m.end());
-		sp[k].first = it->second;
-	}
-
 	sp[k2].second = locate_region(p2 - 1);
+	int lo = sp[k1].first < 0 ? 0 : sp[k1].first;
 	for(int k = k1; k < k2; k++)
 	{
 		p2 = t.exons[k].second;
-		map<int32_t, int>::const_iterator it = m.find(p2);
-		assert(it != m.end());
-		sp[k].second = it->second - 1; 
+		int x = locate_boundary(p2, lo);
+		assert(x < regions.size() && bounds[x] == p2);
+		sp[k].second = x - 1;
+
+		p1 = t.exons[k + 1].first;
+		int y = locate_boundary(p1, x);
+		assert(y < regions.size() && bounds[y] == p1);
+		sp[k + 1].first = y;
+		lo = y;
 	}
 
 	for(int k = k1; k <= k2; k++)
@@ -1993,6 +2069,8 @@ int bundle_bridge::index_references()
 {
 	ref_index.clear();
 	ref_index.resize(regions.size());
+	ref_next.clear();
+	ref_next.resize(regions.size());
 	for(int k = 0; k < ref_phase.size(); k++)
 	{
 		vector<int> &v = ref_phase[k];
@@ -2000,6 +2078,7 @@ int bundle_bridge::index_references()
 		{
 			int x = v[j];
 			ref_index[x].push_back(PI(k, j));
+			if(j + 1 < v.size()) ref_next[x][v[j + 1]].push_back(k);
 		}
 	}
 	return 0;
@@ -2008,18 +2087,28 @@ int bundle_bridge::index_references()
 int bundle_bridge::locate_region(int32_t x)
 {
 	if(regions.size() == 0) return -1;
+	if(x < bounds.front() || x >= bounds.back()) return -1;
+
+	int k = locate_boundary(x, 0);
+	if(bounds[k] == x) return k;
+	else return k - 1;
+}
 
-	int k1 = 0;
-	int k2 = regions.size();
-	while(k1 < k2)
+int bundle_bridge::locate_boundary(int32_t x, int lo) const
+{
+	// index of the first boundary >= x among bounds[lo, end),
+	// by a branchless binary search over the contiguous array
+	int n = bounds.size() - lo;
+	if(n <= 0) return bounds.size();
+
+	const int32_t *b = &(bounds[lo]);
+	while(n > 1)
 	{
-		int m = (k1 + k2) / 2;
-		region &r = regions[m];
-		if(x >= r.lpos && x < r.rpos) return m;
-		else if(x < r.lpos) k2 = m;
-		else k1 = m;
+		int h = n / 2;
+		b = (b[h - 1] < x) ? b + h : b;
+		n -= h;
 	}
-	return -1;
+	return (b - &(bounds[0])) + (*b < x ? 1 : 0);
 }
 
 
@@ -2052,7 +2141,7 @@ int bundle_bridge::build_fragments()
 		if(h.vlist.size() == 0) continue;
 
 		// do not use hi; as long as qname, pos and isize are identical
-		int k = (h.qhash % max_index + h.pos % max_index + (0 - h.isize) % max_index) % max_index;
+		int k = (h.qid % max_index + h.pos % max_index + (0 - h.isize) % max_index) % max_index;
 
 		/*
 		SI si(h.qname, h.hi);
@@ -2071,7 +2160,7 @@ int bundle_bridge::build_fragments()
 		if(h.isize <= 0) continue;
 		if(h.vlist.size() == 0) continue;
 
-		int k = (h.qhash % max_index + h.mpos % max_index + h.isize % max_index) % max_index;
+		int k = (h.qid % max_index + h.mpos % max_index + h.isize % max_index) % max_index;
 
 		/*
 		h.print();
@@ -2104,8 +2193,7 @@ int bundle_bridge::build_fragments()
 			if(z.paired == true) continue;
 			if(z.pos != h.mpos) continue;
 			if(z.isize + h.isize != 0) continue;
-			if(z.qhash != h.qhash) continue;
-			if(z.qname != h.qname) continue;
+			if(z.qid != h.qid) continue;
 
 			x = vv[k][j];
 			break;
@@ -3036,10 +3124,8 @@ int bundle_bridge::extract_nonsupple_HS_hits()
 		if(circ.start != 0 && circ.end != 0)
 		{
 			string chrm_id = bb.chrm.c_str();
-			string circRNA_id = chrm_id + ":" + tostring(circ.start) + "|" + tostring(circ.end) + "|";
 			char strand = bb.strand;
 
-			circ.circRNA_id = circRNA_id;
 			circ.seqname = chrm_id;
 			circ.source = "scallop2_HS";
 			circ.feature = "circRNA";
@@ -3048,18 +3134,14 @@ int bundle_bridge::extract_nonsupple_HS_hits()
 
 			for(int k=0;k<support_jc_rpos.size();k++)
 			{
-				circ.transcript_id = circ.transcript_id + support_jc_rpos[k].qname.c_str() + "|";
+				circ.reads.push_back(support_jc_rpos[k].qid);
 			}
 			for(int k=0;k<support_jc_lpos.size();k++)
 			{
-				circ.transcript_id = circ.transcript_id + support_jc_lpos[k].qname.c_str() + "|";
+				circ.reads.push_back(support_jc_lpos[k].qid);
 			}
 
-			for(int i=0;i<circ.merged_regions.size();i++)
-			{
-				region r = circ.merged_regions[i];
-				circ.circRNA_id = circ.circRNA_id + tostring(r.lpos) + "|" + tostring(r.rpos) + "|";
-			}
+			circ.key.set(chrm_id, circ.start, circ.end, circ.merged_regions);
 
 			//circ.print(0);
 			circ_trsts.push_back(circ);
@@ -3093,8 +3175,6 @@ int bundle_bridge::extract_HS_frags_circRNA()
 		vector<int> v = decode_vlist(fr.paths[0].v);
 
 		string chrm_id = bb.chrm.c_str();
-		string circRNA_id = chrm_id + ":" + tostring(fr.lpos) + "|" + tostring(fr.rpos) + "|";
-		//printf("circularRNA = %s\n",circRNA_id.c_str());
 		
 		char strand = bb.strand;
 		int32_t start = fr.lpos;
@@ -3103,12 +3183,11 @@ int bundle_bridge::extract_HS_frags_circRNA()
 		circ_path.insert(circ_path.begin(), v.begin(), v.end());
 
 		circular_transcript circ;
-		circ.circRNA_id = circRNA_id;
 		circ.seqname = chrm_id;
 		circ.source = "scallop2_HS";
 		circ.feature = "circRNA";
 		circ.gene_id = "gene"; //later change this to bundle id
-		circ.transcript_id = fr.h1->qname; //use hit qname, same for all hits in fragments
+		circ.reads.push_back(fr.h1->qid); //qname id within this bundle, same for all hits in fragments
 		circ.start = start;
 		circ.end = end;
 		circ.circ_path.insert(circ.circ_path.begin(),circ_path.begin(),circ_path.end());
@@ -3129,7 +3208,7 @@ int bundle_bridge::extract_HS_frags_circRNA()
 
 		for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 		{
-			region r(lower(it->first), upper(it->first), '.', '.');
+			region_span r(lower(it->first), upper(it->first));
 			circ.merged_regions.push_back(r);
 		}
 
@@ -3144,11 +3223,7 @@ int bundle_bridge::extract_HS_frags_circRNA()
 			circ.merged_regions[circ.merged_regions.size()-1].rpos = circ.end; 			
 		}
 
-		for(int i=0;i<circ.merged_regions.size();i++)
-    	{
-			region r = circ.merged_regions[i];
-			circ.circRNA_id = circ.circRNA_id + tostring(r.lpos) + "|" + tostring(r.rpos) + "|";
-		}
+		circ.key.set(chrm_id, fr.lpos, fr.rpos, circ.merged_regions);
 
 		circ_trsts.push_back(circ); 
 	}
@@ -3182,8 +3257,6 @@ int bundle_bridge::extract_RO_circRNA()
 		vector<int> v = decode_vlist(fr.paths[0].v);
 
 		string chrm_id = bb.chrm.c_str();
-		string circRNA_id = chrm_id + ":" + tostring(fr.lpos) + "|" + tostring(fr.rpos) + "|";
-		//printf("circularRNA = %s\n",circRNA_id.c_str());
 		
 		char strand = bb.strand;
 		int32_t start = fr.lpos;
@@ -3192,12 +3265,11 @@ int bundle_bridge::extract_RO_circRNA()
 		circ_path.insert(circ_path.begin(), v.begin(), v.end());
 
 		circular_transcript circ;
-		circ.circRNA_id = circRNA_id;
 		circ.seqname = chrm_id;
 		circ.source = "scallop2_RO";
 		circ.feature = "circRNA";
 		circ.gene_id = "gene"; //later change this to bundle id
-		circ.transcript_id = fr.h1->qname; //use hit qname, same for all hits in fragments
+		circ.reads.push_back(fr.h1->qid); //qname id within this bundle, same for all hits in fragments
 		circ.start = start;
 		circ.end = end;
 		circ.circ_path.insert(circ.circ_path.begin(),circ_path.begin(),circ_path.end());
@@ -3218,7 +3290,7 @@ int bundle_bridge::extract_RO_circRNA()
 
 		for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 		{
-			region r(lower(it->first), upper(it->first), '.', '.');
+			region_span r(lower(it->first), upper(it->first));
 			circ.merged_regions.push_back(r);
 		}
 
@@ -3233,11 +3305,7 @@ int bundle_bridge::extract_RO_circRNA()
 			circ.merged_regions[circ.merged_regions.size()-1].rpos = circ.end; 			
 		}
 
-		for(int i=0;i<circ.merged_regions.size();i++)
-    	{
-			region r = circ.merged_regions[i];
-			circ.circRNA_id = circ.circRNA_id + tostring(r.lpos) + "|" + tostring(r.rpos) + "|";
-		}
+		circ.key.set(chrm_id, fr.lpos, fr.rpos, circ.merged_regions);
 
 		circ_trsts.push_back(circ); 
 	}
@@ -3277,21 +3345,20 @@ int bundle_bridge::extract_circ_fragment_pairs()
 
 	// above quadratic implementation seems slow down the program
 	// an index might improve (see below)
-	map<string, int> circ_map;
+	// index circ fragments by interned qname id of h1
+	vector<int> circ_map(qtable.size(), -1);
 	for(int j=0;j<circ_fragments.size();j++)
 	{
 		fragment &fr2 = circ_fragments[j];
-		if(circ_map.find(fr2.h1->qname) == circ_map.end())
-		{
-			circ_map.insert(make_pair(fr2.h1->qname, j));
-		}
+		if(fr2.h1->qid < 0) continue;
+		if(circ_map[fr2.h1->qid] == -1) circ_map[fr2.h1->qid] = j;
 	}
 	for(int i = 0; i < fragments.size(); i++)
 	{
 		fragment &fr1 = fragments[i]; 
-		if(circ_map.find(fr1.h1->qname) == circ_map.end()) continue;
+		if(fr1.h1->qid < 0 || circ_map[fr1.h1->qid] == -1) continue;
 
-		int j = circ_map[fr1.h1->qname];
+		int j = circ_map[fr1.h1->qid];
 		// TODO: check frag, pi, fidx, etc
 		// TODO: add pair to circ_fragment_pairs
 
@@ -3455,6 +3522,219 @@ int bundle_bridge::print_circ_fragment_pairs()
 	return 0;
 }
 
+// UMI of at most 28 nt, 2 bits per base below a leading 1 that keeps
+// lengths apart; placeholders such as "-" and UMIs with bases other
+// than ACGT are treated as missing
+static inline bool pack_umi(const string &u, uint64_t &x)
+{
+	if(u.size() == 0 || u.size() > 28) return false;
+	x = 1;
+	for(int k = 0; k < u.size(); k++)
+	{
+		uint64_t c;
+		if(u[k] == 'A' || u[k] == 'a') c = 0;
+		else if(u[k] == 'C' || u[k] == 'c') c = 1;
+		else if(u[k] == 'G' || u[k] == 'g') c = 2;
+		else if(u[k] == 'T' || u[k] == 't') c = 3;
+		else return false;
+		x = (x << 2) | c;
+	}
+	return true;
+}
+
+// (mate positions, orientation, masked position, UMI with that base cleared)
+struct umi_key
+{
+	int64_t p;
+	uint64_t u;
+	bool operator==(const umi_key &k) const { return p == k.p && u == k.u; }
+};
+
+struct umi_key_hash
+{
+	size_t operator()(const umi_key &k) const { return (size_t)(k.p * 0x9e3779b97f4a7c15ULL ^ k.u); }
+};
+
+int bundle_bridge::dedup_umi_fragments()
+{
+	// group normal fragments by (mate positions, orientation) and UMI with
+	// at most one mismatch; the first read of each molecule is kept and
+	// all fragments of the other reads are removed
+	vector<bool> dup(qtable.size(), false);
+	unordered_map<umi_key, int, umi_key_hash> index;		// key with one base masked -> representative
+	int nd = 0;
+	for(int i = 0; i < fragments.size(); i++)
+	{
+		fragment &fr = fragments[i];
+		uint64_t x;
+		if(fr.h1->qid < 0 || pack_umi(fr.h1->umi, x) == false) continue;
+
+		int n = fr.h1->umi.size();
+		umi_key key;
+		key.p = pack(fr.h1->pos, fr.h2->pos);
+
+		// bits 0-56 hold the UMI, 57-61 the masked position, 62 the orientation
+		uint64_t b = ((fr.h1->flag & 0x10) >= 1 ? 1ULL : 0ULL) << 62;
+
+		int r = -1;
+		for(int k = 0; k < n && r == -1; k++)
+		{
+			key.u = (x & ~(3ULL << (2 * k))) | ((uint64_t)k << 57) | b;
+			unordered_map<umi_key, int, umi_key_hash>::iterator it = index.find(key);
+			if(it != index.end()) r = it->second;
+		}
+
+		if(r == -1)
+		{
+			for(int k = 0; k < n; k++)
+			{
+				key.u = (x & ~(3ULL << (2 * k))) | ((uint64_t)k << 57) | b;
+				index.insert(pair<umi_key, int>(key, i));
+			}
+		}
+		else
+		{
+			fragments[r].umi_cnt++;
+			dup[fr.h1->qid] = true;
+			nd++;
+		}
+	}
+
+	if(nd == 0) return 0;
+
+	// remove fragments of duplicate reads and remap partner indices
+	vector<int> m1(fragments.size(), -1);
+	vector<int> m2(circ_fragments.size(), -1);
+	vector<fragment> v1;
+	vector<fragment> v2;
+	for(int i = 0; i < fragments.size(); i++)
+	{
+		if(fragments[i].h1->qid >= 0 && dup[fragments[i].h1->qid] == true) continue;
+		m1[i] = v1.size();
+		v1.push_back(fragments[i]);
+	}
+	for(int i = 0; i < circ_fragments.size(); i++)
+	{
+		if(circ_fragments[i].h1->qid >= 0 && dup[circ_fragments[i].h1->qid] == true) continue;
+		m2[i] = v2.size();
+		v2.push_back(circ_fragments[i]);
+	}
+	for(int i = 0; i < v1.size(); i++)
+	{
+		fragment &fr = v1[i];
+		if(fr.fidx >= 0) fr.fidx = m1[fr.fidx];
+		if(fr.pi >= 0) fr.pi = m2[fr.pi];
+	}
+	for(int i = 0; i < v2.size(); i++)
+	{
+		fragment &fr = v2[i];
+		if(fr.fidx >= 0) fr.fidx = m2[fr.fidx];
+		if(fr.pi >= 0) fr.pi = m1[fr.pi];
+	}
+
+	if(verbose >= 1) printf("UMI dedup: %lu -> %lu fragments, %lu -> %lu circ fragments\n", fragments.size(), v1.size(), circ_fragments.size(), v2.size());
+
+	fragments.swap(v1);
+	circ_fragments.swap(v2);
+	return 0;
+}
+
+int bundle_bridge::collapse_fragments(vector<fragment> &frags, const vector<fragment> &others, vector<fragment> &all, vector<int> &cls)
+{
+	// move frags to all and keep one representative per class of equal
+	// fragments in frags; members are chained to it by fragment::append
+	all.clear();
+	all.swap(frags);
+	cls.assign(all.size(), -1);
+
+	// only fragments whose hits belong to no other fragment can join a chain;
+	// circ fragments share hits with normal ones, so others are counted too
+	map<hit*, int> used;
+	for(int i = 0; i < all.size(); i++)
+	{
+		used[all[i].h1]++;
+		used[all[i].h2]++;
+	}
+	for(int i = 0; i < others.size(); i++)
+	{
+		used[others[i].h1]++;
+		used[others[i].h2]++;
+	}
+
+	map<PI32, vector<int> > m;		// (lpos, rpos) -> representatives
+	for(int i = 0; i < all.size(); i++)
+	{
+		fragment &fr = all[i];
+		vector<int> &v = m[PI32(fr.lpos, fr.rpos)];
+
+		int k = -1;
+		bool b = (fr.paths.size() == 0 && used[fr.h1] == 1 && used[fr.h2] == 1);
+		for(int j = 0; b == true && j < v.size(); j++)
+		{
+			if(frags[v[j]].equal(fr) == false) continue;
+			k = v[j];
+			break;
+		}
+
+		if(k == -1)
+		{
+			cls[i] = frags.size();
+			frags.push_back(fr);
+			if(b == true) v.push_back(cls[i]);
+		}
+		else
+		{
+			frags[k].append(fr);
+			cls[i] = k;
+		}
+	}
+	return 0;
+}
+
+int bundle_bridge::expand_fragments(vector<fragment> &frags, vector<fragment> &all, const vector<int> &cls)
+{
+	// copy bridging results of representatives back; hits were already
+	// updated along the chains, which are released here
+	for(int i = 0; i < all.size(); i++)
+	{
+		const fragment &fx = frags[cls[i]];
+		all[i].paths = fx.paths;
+		all[i].candidate_path_count = fx.candidate_path_count;
+	}
+	for(int i = 0; i < all.size(); i++)
+	{
+		all[i].h1->next = NULL;
+		all[i].h2->next = NULL;
+	}
+	frags.swap(all);
+	all.clear();
+	return 0;
+}
+
+int bundle_bridge::collect_bsjs()
+{
+	bsj_counts.clear();
+
+	for(int i=0;i<circ_fragment_pairs.size();i++)
+	{
+		fragment &fr1 = circ_fragment_pairs[i].first;
+		fragment &fr2 = circ_fragment_pairs[i].second;
+
+		// same coordinates as join_circ_fragment_pairs
+		int64_t p;
+		if(fr2.is_compatible == 1) p = pack(fr1.lpos, fr2.rpos);
+		else if(fr2.is_compatible == 2) p = pack(fr2.lpos, fr1.rpos);
+		else continue;
+
+		if(high32(p) >= low32(p)) continue;
+
+		PI &c = bsj_counts[p];
+		c.first++;
+		if(fr2.h1->is_fake == true || fr2.h2->is_fake == true) c.second++;
+	}
+	return 0;
+}
+
 int bundle_bridge::join_circ_fragment_pairs(int32_t length_high)
 {
 	for(int i=0;i<circ_fragment_pairs.size();i++)
@@ -3835,8 +4115,6 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		// printf("\n\n");
 	
 		string chrm_id = bb.chrm.c_str();
-		string circRNA_id = chrm_id + ":" + tostring(fr1.lpos) + "|" + tostring(fr2.rpos) + "|";
-		//printf("circularRNA = %s\n",circRNA_id.c_str());
 		
 		char strand = bb.strand;
 		int32_t start = fr1.lpos;
@@ -3845,7 +4123,6 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		circ_path.insert(circ_path.begin(), p.v.begin(), p.v.end());
 
 		circular_transcript circ;
-		circ.circRNA_id = circRNA_id;
 		circ.seqname = chrm_id;
 		circ.source = "TERRACE";
 		circ.path_score = fr2.paths[0].score;
@@ -3855,6 +4132,7 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		else if(circ.path_type == 3) circ.path_count_3++;
 		else if(circ.path_type == 4) circ.path_count_4++;
 		circ.bundle_size = fragments.size();
+		circ.sample_rate = bb.sample_rate;
 		circ.ref_trsts_size = ref_trsts.size();
 		circ.candidate_path_count = fr2.candidate_path_count;
 
@@ -3878,7 +4156,8 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		circ.feature = "circRNA";
 		circ.gene_id = "gene"; //later change this to bundle id
-		circ.transcript_id = fr1.h1->qname; //use hit qname, same for all hits in fragments
+		circ.reads.push_back(fr1.h1->qid); //qname id within this bundle, same for all hits in fragments
+		if(umi_dedup == true) circ.umi_reads = fr1.umi_cnt; //reads of the molecule fr1 stands for
 		circ.start = start;
 		circ.end = end;
 		circ.circ_path.insert(circ.circ_path.begin(),circ_path.begin(),circ_path.end());
@@ -3900,7 +4179,7 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 		{
-			region r(lower(it->first), upper(it->first), '.', '.');
+			region_span r(lower(it->first), upper(it->first));
 			circ.merged_regions.push_back(r);
 		}
 
@@ -3921,16 +4200,15 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		for(int i=0;i<circ.merged_regions.size();i++)
     	{
-			region r = circ.merged_regions[i];
+			const region_span &r = circ.merged_regions[i];
 			int32_t exon_len = r.rpos-r.lpos;
 
-			circ.circRNA_id = circ.circRNA_id + tostring(r.lpos) + "|" + tostring(r.rpos) + "|";
-
 			total_exon_length += exon_len;
 			if(exon_len > max_exon_length) max_exon_length = exon_len;
 			if(exon_len < min_exon_length) min_exon_length = exon_len;
 		}		
 		
+		circ.key.set(chrm_id, fr1.lpos, fr2.rpos, circ.merged_regions);
 		circ.exon_count = circ.merged_regions.size();
 		circ.total_exon_length = total_exon_length;
 		circ.max_exon_length = max_exon_length;
@@ -3974,8 +4252,6 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		// printf("\n\n");
 		
 		string chrm_id = bb.chrm.c_str();
-		string circRNA_id = chrm_id + ":" + tostring(fr2.lpos) + "|" + tostring(fr1.rpos) + "|";
-		//printf("circularRNA = %s\n",circRNA_id.c_str());
 		
 		char strand = bb.strand;
 		int32_t start = fr2.lpos;
@@ -3984,7 +4260,6 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		circ_path.insert(circ_path.begin(), p.v.begin(), p.v.end());
 
 		circular_transcript circ;
-		circ.circRNA_id = circRNA_id;
 		circ.seqname = chrm_id;
 		circ.source = "TERRACE";
 		circ.path_score = fr2.paths[0].score;
@@ -3994,6 +4269,7 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 		else if(circ.path_type == 3) circ.path_count_3++;
 		else if(circ.path_type == 4) circ.path_count_4++;
 		circ.bundle_size = fragments.size();
+		circ.sample_rate = bb.sample_rate;
 		circ.ref_trsts_size = ref_trsts.size();
 		circ.candidate_path_count = fr2.candidate_path_count;
 
@@ -4017,7 +4293,8 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		circ.feature = "circRNA";
 		circ.gene_id = "gene"; //later change this to bundle id
-		circ.transcript_id = fr1.h1->qname; //use hit qname, same for all hits in fragments
+		circ.reads.push_back(fr1.h1->qid); //qname id within this bundle, same for all hits in fragments
+		if(umi_dedup == true) circ.umi_reads = fr1.umi_cnt; //reads of the molecule fr1 stands for
 		circ.start = start;
 		circ.end = end;
 		circ.circ_path.insert(circ.circ_path.begin(),circ_path.begin(),circ_path.end());
@@ -4039,7 +4316,7 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		for(JIMI it = jmap.begin(); it != jmap.end(); it++)
 		{
-			region r(lower(it->first), upper(it->first), '.', '.');
+			region_span r(lower(it->first), upper(it->first));
 			circ.merged_regions.push_back(r);
 		}
 
@@ -4060,16 +4337,15 @@ int bundle_bridge::join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int
 
 		for(int i=0;i<circ.merged_regions.size();i++)
     	{
-			region r = circ.merged_regions[i];
+			const region_span &r = circ.merged_regions[i];
 			int32_t exon_len = r.rpos-r.lpos;
 
-			circ.circRNA_id = circ.circRNA_id + tostring(r.lpos) + "|" + tostring(r.rpos) + "|";
-
 			total_exon_length += exon_len;
 			if(exon_len > max_exon_length) max_exon_length = exon_len;
 			if(exon_len < min_exon_length) min_exon_length = exon_len;
 		}		
 
+		circ.key.set(chrm_id, fr2.lpos, fr1.rpos, circ.merged_regions);
 		circ.exon_count = circ.merged_regions.size();
 		circ.total_exon_length = total_exon_length;
 		circ.max_exon_length = max_exon_length;
@@ -4167,12 +4443,16 @@ int bundle_bridge::group_fragments()
 
 int32_t bundle_bridge::compute_aligned_length(int32_t k1l, int32_t k2r, const vector<int>& v)
 {
+	// bounds are prefix sums of region lengths (up to an offset), so
+	// each run of consecutive regions costs a single subtraction
 	if(v.size() == 0) return 0;
 	int32_t flen = 0;
-	for(int i = 0; i < v.size(); i++)
+	int p = 0;
+	for(int i = 1; i <= v.size(); i++)
 	{
-		int k = v[i];
-		flen += regions[k].rpos - regions[k].lpos;
+		if(i < v.size() && v[i] == v[i - 1] + 1) continue;
+		flen += bounds[v[i - 1] + 1] - bounds[v[p]];
+		p = i;
 	}
 	return flen - k1l - k2r;
 }
@@ -4232,17 +4512,16 @@ int bundle_bridge::print(int index)
 	return 0;
 }
 
-vector<int32_t> bundle_bridge::build_accumulate_length(const vector<int> &v)
+int bundle_bridge::build_accumulate_length(const vector<int> &v, vector<int32_t> &acc)
 {
 	int32_t x = 0;
-	vector<int32_t> acc;
 	acc.resize(v.size());
 	for(int i = 0; i < v.size(); i++)
 	{
-		x += regions[v[i]].rpos - regions[v[i]].lpos;
+		x += bounds[v[i] + 1] - bounds[v[i]];
 		acc[i] = x;
 	}
-	return acc;
+	return 0;
 }
 
 vector<int32_t> bundle_bridge::get_aligned_intervals(fragment &fr)
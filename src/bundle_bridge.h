@@ -18,15 +18,20 @@ See LICENSE for licensing.
 #include "transcript.h"
 #include "circular_transcript.h"
 #include "reference.h"
+#include "RO_index.h"
+#include "qname_table.h"
+#include "profiler.h"
 #include "htslib/faidx.h"
 
 using namespace std;
 
+class bridger;
+
 class bundle_bridge
 {
 public:
 	bundle_bridge(bundle_base &b, reference &r);
-	bundle_bridge(bundle_base &b, reference &r, map <string, int> RO_reads_map, faidx_t *fai);
+	bundle_bridge(bundle_base &b, reference &r, const RO_index &ro_index, faidx_t *fai, bundle_profile *prof = NULL);
 	bundle_bridge(bundle_base &bb);
 	virtual ~bundle_bridge();
 
@@ -37,10 +42,13 @@ public:
 	vector<fragment> fragments;			// to-be-filled fragments
 	vector<fragment> circ_fragments;	// to-be-filled fragments
 	faidx_t *fai;						//pointer to fetch fasta seq from region
+	qname_table qtable;					// interned read names of bb.hits
+	bundle_profile *prof;				// per-stage timers and counters, NULL if profiling is disabled
 
 	vector<pair<fragment,fragment>> circ_fragment_pairs;	//bridged fragment pairs for circular RNA
 	vector<circular_transcript> circ_trsts; //a vector of circular transcripts class objs, with duplicates
 	vector<circular_transcript> circ_trsts_HS; ////a vector of circular transcripts from all possible H/S reads, with duplicates
+	map<int64_t, PI> bsj_counts;		// bsj-only mode: BSJ (start, end) -> (#reads, #soft-clip rescued reads)
 
 	vector<string> HS_both_side_reads; //for statistics of RO reads from CIRI-full
 	vector<string> chimeric_reads; //for statistics of RO reads from CIRI-full
@@ -54,21 +62,27 @@ public:
 	vector<junction> filtered_junctions; // junctions with higher support count
 	map<int64_t, char> junc_map;		// map junction to strandness
 	vector<region> regions;				// pexons
+	vector<int32_t> bounds;				// region boundaries: lpos of each region followed by rpos of the last;
+										// bounds[k] - bounds[0] is the prefix sum of region lengths
 	vector<partial_exon> pexons;		// partial exons
 	vector<transcript> ref_trsts;		// overlaped genes in reference
 	vector< vector<int> > ref_phase;	// phasing paths for ref transcripts
 	vector< vector<PI> > ref_index;		// the set of trsts that contain each region
+	vector< map<int, vector<int> > > ref_next;	// for region x and its successor y, the sorted trsts containing (x, y)
+	vector<int> dv1, dv2;				// scratch buffers for decoding vlists
 
 public:
-	int build(map <string, int> RO_reads_map, faidx_t *_fai);
+	int build(const RO_index &ro_index, faidx_t *_fai);
+	int set_profile_counters(const bridger *bdg);
 	int print(int index);
 	int32_t compute_aligned_length(int32_t k1l, int32_t k2r, const vector<int>& v);
-	vector<int32_t> build_accumulate_length(const vector<int> &v);
+	int build_accumulate_length(const vector<int> &v, vector<int32_t> &acc);
 	vector<int32_t> get_aligned_intervals(fragment &fr);
 	vector<int32_t> get_splices(fragment &fr);
 
 public:
-	int set_hits_RO_parameter(map <string, int> RO_reads_map);
+	int set_hits_RO_parameter(const RO_index &ro_index);
+	int intern_qnames();
 	int set_chimeric_cigar_positions();
 	int build_supplementaries();
 	int build_junctions();
@@ -93,8 +107,12 @@ public:
 	int extract_RO_circRNA();
 	int extract_HS_frags_circRNA();
 	int extract_circ_fragment_pairs();
+	int dedup_umi_fragments();
+	int collapse_fragments(vector<fragment> &frags, const vector<fragment> &others, vector<fragment> &all, vector<int> &cls);
+	int expand_fragments(vector<fragment> &frags, vector<fragment> &all, const vector<int> &cls);
 	int print_circ_fragment_pairs();
 	int join_circ_fragment_pairs(int32_t length_high);
+	int collect_bsjs();
 	int join_circ_fragment_pair(pair<fragment,fragment> &fr_pair, int ex1, int ex2, int left_boundary_flag, int right_boundary_flag);
 	int print_circRNAs();
 	char infer_circ_strand(const vector<int> &p);
@@ -103,8 +121,8 @@ public:
 
 	int compute_strand();
 	int align_hits_transcripts();
-	int align_hit(const map<int32_t, int> &m, const hit &h, vector<int> &v);
-	int align_transcript(const map<int32_t, int> &m, const transcript &t, vector<int> &v);
+	int align_hit(const hit &h, vector<int> &v);
+	int align_transcript(const transcript &t, vector<int> &v);
 	int align_fake_hits();
 	int remove_tiny_boundaries();
 	int remove_tiny_boundaries_fake_hits();
@@ -114,6 +132,7 @@ public:
 	int set_fragment_length(fragment &fr);
 	int index_references();
 	int locate_region(int32_t x);
+	int locate_boundary(int32_t x, int lo) const;
 };
 
 #endif
@@ -0,0 +1,283 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+
+#include "config.h"
+#include "circ_merger.h"
+
+circ_merger::circ_merger(const string &chrm)
+{
+	this->chrm = chrm;
+}
+
+int circ_merger::process()
+{
+	remove_long_exon_circ_trsts();
+	remove_duplicate_circ_trsts();
+
+	ostringstream fcirc;
+	write_circular(fcirc);
+	gtf = fcirc.str();
+
+	if(feature_file != "")
+	{
+		ostringstream fout;
+		write_feature(fout);
+		features = fout.str();
+	}
+	return 0;
+}
+
+int circ_merger::remove_long_exon_circ_trsts()
+{
+	for(int i=0;i<circular_trsts.size();i++)
+	{	
+		circular_transcript circ = circular_trsts[i];
+		int long_flag = 0;
+		
+		//remove long exon FP
+		if(circ.merged_regions.size() == 1) //check for single exons
+		{
+			for(int j=0;j<circ.merged_regions.size();j++)
+			{
+				if(circ.merged_regions[j].rpos-circ.merged_regions[j].lpos > max_single_exon_length)
+				{
+					long_flag = 1;
+					break;
+				}
+			}
+		}
+		else if(circ.merged_regions.size() > 1) //check for multi exons
+		{
+			for(int j=0;j<circ.merged_regions.size();j++)
+			{
+				if(circ.merged_regions[j].rpos-circ.merged_regions[j].lpos > max_multi_exon_length)
+				{
+					long_flag = 1;
+					break;
+				}
+			}
+		}
+
+		//try to remove FP by discarding circRNAs with lots of vertices from many small junctions
+		if(circ.circ_path.size() > max_circ_vsize)
+		{
+			long_flag = 1;
+		}
+
+		if(long_flag == 0)
+		{
+			circular_trsts_long_removed.push_back(circ);
+		}
+
+		if(long_flag == 1)
+		{
+			//printf("Printing long exon circRNAs removed:\n");
+			//circ.print(i+1);
+		}
+	}
+	return 0;
+}
+
+int circ_merger::remove_duplicate_circ_trsts()
+{
+	for(int i=0;i<circular_trsts_long_removed.size();i++)
+	{
+		circular_transcript circ = circular_trsts_long_removed[i];
+
+		map<circ_key, pair<circular_transcript, int>>::iterator it = circ_trst_map.find(circ.key);
+		if(it != circ_trst_map.end())// already circRNA present in map
+		{
+			//increase coverage count
+			it->second.second++;
+
+			//accumulate features of all identical circRNAs
+			circular_transcript &ct = it->second.first;
+			ct.supple_len = ct.supple_len + min(circ.supple_len,read_length-circ.supple_len);
+			ct.path_score = ct.path_score + circ.path_score;
+			ct.fake_count = ct.fake_count + circ.fake_count;
+			ct.path_count_1 = ct.path_count_1 + circ.path_count_1;
+			ct.path_count_2 = ct.path_count_2 + circ.path_count_2;
+			ct.path_count_3 = ct.path_count_3 + circ.path_count_3;
+			ct.path_count_4 = ct.path_count_4 + circ.path_count_4;
+			ct.candidate_path_count= ct.candidate_path_count + circ.candidate_path_count;
+			ct.umi_reads = ct.umi_reads + circ.umi_reads;
+
+			//collect ids of all reads generating this circRNA
+			ct.reads.insert(ct.reads.end(), circ.reads.begin(), circ.reads.end());
+		}
+		else //circRNA not present in map
+		{
+			circ.supple_len = min(circ.supple_len,read_length-circ.supple_len);
+			circ_trst_map.insert(pair<circ_key,pair<circular_transcript, int>>(circ.key,pair<circular_transcript, int>(circ,1)));
+		}
+	}
+
+	map<circ_key, pair<circular_transcript, int>>::iterator itn;
+	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
+	{
+		circular_transcript &circ = itn->second.first;
+		//set score and coverage
+		circ.coverage = itn->second.second;
+		circ.score = (double)circ.coverage;
+
+		//keep each supporting read once; both mates may support the same circRNA
+		sort(circ.reads.begin(), circ.reads.end());
+		circ.reads.erase(unique(circ.reads.begin(), circ.reads.end()), circ.reads.end());
+		
+		//printf("key = %s, count = %d\n",itn->first.str().c_str(),itn->second.second);
+	}
+
+	//merge circRNAs that have different end boundaries but same intron chain into that with higher coverage (chimeric)
+	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
+	{
+		//printf("start of check\n");
+		circular_transcript &circ = itn->second.first;
+		const circ_key &key = itn->first;
+
+		if(circ.source != "TERRACE") continue;
+
+		int flag_collision = 0;
+		map<circ_key, pair<circular_transcript, int>>::iterator itn1;
+		for(itn1 = circ_trst_merged_map.begin(); itn1 != circ_trst_merged_map.end(); itn1++)
+		{
+			circular_transcript &old_circ = itn1->second.first;
+
+			//don't check with already existing RO circRNAs
+			//if(old_circ.source == "scallop2_RO") continue;
+
+			//same intron chain, i.e., same middle coordinates except first and last coordinate
+			if(key.same_chain(itn1->first) && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff)
+			{
+				if(circ.coverage > old_circ.coverage)
+				{
+					circ_trst_merged_map.erase(itn1);
+					circ_trst_merged_map.insert(pair<circ_key,pair<circular_transcript, int>>(circ.key,pair<circular_transcript, int>(circ,circ.coverage)));
+					flag_collision = 1;
+					break;
+				}
+				flag_collision = 1;
+			}
+		}
+
+		if(flag_collision == 0) //end diff and intron chain condition did not match for any entry in circ_trst_merged_map, so enter separately
+		{
+			circ_trst_merged_map.insert(pair<circ_key,pair<circular_transcript, int>>(circ.key,pair<circular_transcript, int>(circ,circ.coverage)));
+		}
+	}
+
+	//merge circRNAs that have different end boundaries but same intron chain into that with higher coverage (more chimeric)
+	for(itn = circ_trst_map.begin(); itn != circ_trst_map.end(); itn++)
+	{
+		//printf("start of check\n");
+		circular_transcript &circ = itn->second.first;
+		const circ_key &key = itn->first;
+
+		if(circ.source != "TERRACE_NEW") continue;
+
+		int flag_collision = 0;
+		map<circ_key, pair<circular_transcript, int>>::iterator itn1;
+		for(itn1 = circ_trst_merged_map.begin(); itn1 != circ_trst_merged_map.end(); itn1++)
+		{
+			circular_transcript &old_circ = itn1->second.first;
+
+			//don't check with already existing RO circRNAs
+			//if(old_circ.source == "scallop2_RO") continue;
+
+			//same intron chain, i.e., same middle coordinates except first and last coordinate
+			if(key.same_chain(itn1->first) && abs(circ.start-old_circ.start) < same_chain_circ_end_diff && abs(circ.end-old_circ.end) < same_chain_circ_end_diff)
+			{
+				if(circ.coverage > old_circ.coverage)
+				{
+					circ_trst_merged_map.erase(itn1);
+					circ_trst_merged_map.insert(pair<circ_key,pair<circular_transcript, int>>(circ.key,pair<circular_transcript, int>(circ,circ.coverage)));
+					flag_collision = 1;
+					break;
+				}
+				flag_collision = 1;
+			}
+		}
+
+		if(flag_collision == 0) //end diff and intron chain condition did not match for any entry in circ_trst_merged_map, so enter separately
+		{
+			circ_trst_merged_map.insert(pair<circ_key,pair<circular_transcript, int>>(circ.key,pair<circular_transcript, int>(circ,circ.coverage)));
+		}
+	}
+
+	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	{
+		circular_transcript &circ = itn->second.first;
+		circ.coverage = itn->second.second;
+		//circ.score = circ.score/circ.bundle_size;
+		//printf("key = %s, count = %d\n",itn->first.str().c_str(),itn->second.second);
+	}
+
+
+	return 0;
+}
+
+int circ_merger::write_circular(ostream &fout) const
+{
+	map<circ_key, pair<circular_transcript, int>>::const_iterator itn;
+	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	{
+		const circular_transcript &circ = itn->second.first;
+		circ.write(fout);
+	}
+	return 0;
+}
+
+int circ_merger::write_feature(ostream &fout) const
+{
+	map<circ_key, pair<circular_transcript, int>>::const_iterator itn;
+	for(itn = circ_trst_merged_map.begin(); itn != circ_trst_merged_map.end(); itn++)
+	{
+		const circular_transcript &circ = itn->second.first;
+		fout<<circ.key.str()<<","<<circ.bundle_size<<","<<circ.ref_trsts_size<<","<<circ.coverage<<","<<circ.fake_count<<","<<circ.supple_len<<","<<circ.candidate_path_count<<","<<circ.path_score<<","<<circ.path_count_1<<","<<circ.path_count_2<<","<<circ.path_count_3<<","<<circ.path_count_4<<","<<circ.exon_count<<","<<circ.total_exon_length<<","<<circ.max_exon_length<<","<<circ.min_exon_length<<","<<circ.avg_exon_length;
+		if(max_bundle_hits > 0) fout<<","<<circ.sample_rate;
+		fout<<"\n";
+	}
+	return 0;
+}
+
+bool compare_circ_merger_chrm(const circ_merger &x, const circ_merger &y)
+{
+	// same order as the chrm part of circ_key, so that the concatenated
+	// output follows the order of a single genome-wide map
+	return (x.chrm + ":") < (y.chrm + ":");
+}
+
+static void process_circ_mergers_worker(vector<circ_merger> *cms, const vector<PI> *order, atomic<int> *next)
+{
+	for(int j = (*next)++; j < order->size(); j = (*next)++)
+	{
+		(*cms)[(*order)[j].second].process();
+	}
+}
+
+int process_circ_mergers(vector<circ_merger> &cms, int threads)
+{
+	// larger chromosomes first; each worker takes the next one when done
+	vector<PI> order(cms.size());
+	for(int i = 0; i < cms.size(); i++) order[i] = PI(0 - (int)cms[i].circular_trsts.size(), i);
+	sort(order.begin(), order.end());
+
+	if(threads > (int)order.size()) threads = order.size();
+	if(threads < 1) threads = 1;
+
+	atomic<int> next(0);
+	vector<thread> workers;
+	for(int i = 1; i < threads; i++) workers.push_back(thread(process_circ_mergers_worker, &cms, &order, &next));
+	process_circ_mergers_worker(&cms, &order, &next);
+	for(int i = 0; i < workers.size(); i++) workers[i].join();
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __CIRC_MERGER_H__
+#define __CIRC_MERGER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "circular_transcript.h"
+
+using namespace std;
+
+// post-processing of the circRNA candidates of one chromosome: removes long
+// exon circRNAs, collapses duplicates and merges circRNAs of the same intron
+// chain; independent of other chromosomes, so instances can run in parallel
+class circ_merger
+{
+public:
+	circ_merger(const string &chrm);
+
+public:
+	string chrm;
+	vector<circular_transcript> circular_trsts; //a vector of circular transcripts class objs of this chrm, with duplicates
+	vector<circular_transcript> circular_trsts_long_removed; //circular_trsts with long exon circs removed
+	map <circ_key, pair<circular_transcript, int>> circ_trst_map; // a map of distinct circ trsts with circRNA key and the corresponding circRNA object
+	map <circ_key, pair<circular_transcript, int>> circ_trst_merged_map; // map with circRNAs having few bp diff ends but same intron chains merged
+	string gtf;			// rendered GTF records of circ_trst_merged_map
+	string features;	// rendered feature rows of circ_trst_merged_map, if feature_file is given
+
+public:
+	int process();
+	int remove_long_exon_circ_trsts();
+	int remove_duplicate_circ_trsts();
+	int write_circular(ostream &fout) const;
+	int write_feature(ostream &fout) const;
+};
+
+bool compare_circ_merger_chrm(const circ_merger &x, const circ_merger &y);
+int process_circ_mergers(vector<circ_merger> &cms, int threads);
+
+#endif
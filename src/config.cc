@@ -48,6 +48,11 @@ int max_edit_distance = 10;
 int32_t min_bundle_gap = 100;		
 int min_num_hits_in_bundle = 0; //5	
 int min_num_splices_in_bundle = 15;	// not used; accept bundle if #hits with splices is at least this number
+bool use_evidence_gate = true;		// skip bundles without any supplementary, SA or long soft-clip hits
+bool split_bundles = false;			// cut bundles on coverage gaps only; mates/supplementaries across a cut are carried over
+int max_bundle_hits = 0;			// downsample non-chimeric reads of bundles with more hits than this, 0 to disable
+bool collapse_duplicate_fragments = true;	// bridge identical fragments once as a weighted fragment
+bool umi_dedup = false;				// keep one fragment per UMI molecule (UB tag, Hamming distance <= 1)
 uint32_t min_mapping_quality = 0; //1
 int32_t min_splice_boundary_hits = 1;
 bool use_second_alignment = false; //change if needed
@@ -107,10 +112,31 @@ string output_file = "";
 string output_file1 = "";
 string output_circ_file = "";
 string cirifull_file = "";
+int ro_bloom_bits = 10; //bits per RO read in the bloom prefilter of RO index, 0 to disable
 string feature_file = "";
+string read_assignment_file = "";	// supporting read -> circRNA assignment (TSV), written if given
+
+// for targeted assembly
+bool targeted_assembly = false;		// scan for back-splice candidates first, then assemble only their windows (needs index)
+int32_t targeted_window = 10000;		// flank added around each candidate read and its mate
+
+// for bsj-only mode
+bool bsj_only = false;				// report back-splice junctions with read counts (BED) to -o, skip bridging
+
+// for bundle cost estimation
+double cost_weight_hit = 1.0;		// estimated cost per hit
+double cost_weight_spliced = 2.0;	// estimated extra cost per spliced hit
+double cost_weight_suppl = 20.0;	// estimated extra cost per supplementary or SA hit
+double cost_weight_span = 0.001;	// estimated cost per base of bundle span
+string bundle_cost_file = "";		// per-bundle report of estimated cost and actual time
+string profile_file = "";			// per-bundle, per-stage timers and counters (TSV, or JSON if named *.json)
+int profile_top = 10;				// number of slowest bundles summarized at exit when profiling
+string metrics_file = "";			// JSON report of run metrics, rewritten periodically and at exit
+double metrics_interval = 60;		// seconds between periodic rewrites of metrics_file, 0 for exit only
 
 // for controling
 int batch_bundle_size = 100;
+int num_threads = 1;				// threads for per-chromosome post-processing of circRNAs
 int verbose = 0;//1
 string version = "v1.1.2";
 
@@ -152,6 +178,11 @@ int parse_arguments(int argc, const char ** argv)
 			cirifull_file = string(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--ro_bloom_bits")
+		{
+			ro_bloom_bits = atoi(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "-fa")
 		{
 			fa_parameter= true;
@@ -164,6 +195,11 @@ int parse_arguments(int argc, const char ** argv)
 			feature_file = string(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--read_assignment_file")
+		{
+			read_assignment_file = string(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "-r")
 		{
 			r_parameter = true;
@@ -359,6 +395,103 @@ int parse_arguments(int argc, const char ** argv)
 			else use_second_alignment = false;
 			i++;
 		}
+		else if(string(argv[i]) == "--use_evidence_gate")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") use_evidence_gate = true;
+			else use_evidence_gate = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--bsj_only" || string(argv[i]) == "--bsj-only")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") bsj_only = true;
+			else bsj_only = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--cost_weight_hit")
+		{
+			cost_weight_hit = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--cost_weight_spliced")
+		{
+			cost_weight_spliced = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--cost_weight_suppl")
+		{
+			cost_weight_suppl = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--cost_weight_span")
+		{
+			cost_weight_span = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--bundle_cost_file")
+		{
+			bundle_cost_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--profile_file")
+		{
+			profile_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--profile_top")
+		{
+			profile_top = atoi(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--metrics")
+		{
+			metrics_file = string(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--metrics_interval")
+		{
+			metrics_interval = atof(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--split_bundles")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") split_bundles = true;
+			else split_bundles = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--max_bundle_hits")
+		{
+			max_bundle_hits = atoi(argv[i + 1]);
+			i++;
+		}
+		else if(string(argv[i]) == "--collapse_duplicate_fragments")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") collapse_duplicate_fragments = true;
+			else collapse_duplicate_fragments = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--umi_dedup")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") umi_dedup = true;
+			else umi_dedup = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--targeted_assembly")
+		{
+			string s(argv[i + 1]);
+			if(s == "true") targeted_assembly = true;
+			else targeted_assembly = false;
+			i++;
+		}
+		else if(string(argv[i]) == "--targeted_window")
+		{
+			targeted_window = atoi(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "--uniquely_mapped_only")
 		{
 			string s(argv[i + 1]);
@@ -376,6 +509,11 @@ int parse_arguments(int argc, const char ** argv)
 			batch_bundle_size = atoi(argv[i + 1]);
 			i++;
 		}
+		else if(string(argv[i]) == "--threads")
+		{
+			num_threads = atoi(argv[i + 1]);
+			i++;
+		}
 		else if(string(argv[i]) == "--min_bridging_score")
 		{
 			min_bridging_score = atof(argv[i + 1]);
@@ -490,6 +628,23 @@ int print_parameters()
 	printf("max_fset_score = %lf\n", max_fset_score);
 	printf("min_soft_clip_len = %d\n", min_soft_clip_len);
 	printf("min_jaccard = %lf\n", min_jaccard);
+	printf("use_evidence_gate = %c\n", use_evidence_gate ? 'T' : 'F');
+	printf("split_bundles = %c\n", split_bundles ? 'T' : 'F');
+	printf("max_bundle_hits = %d\n", max_bundle_hits);
+	printf("collapse_duplicate_fragments = %c\n", collapse_duplicate_fragments ? 'T' : 'F');
+	printf("umi_dedup = %c\n", umi_dedup ? 'T' : 'F');
+	printf("targeted_assembly = %c\n", targeted_assembly ? 'T' : 'F');
+	printf("targeted_window = %d\n", targeted_window);
+	printf("bsj_only = %c\n", bsj_only ? 'T' : 'F');
+	printf("cost_weight_hit = %lf\n", cost_weight_hit);
+	printf("cost_weight_spliced = %lf\n", cost_weight_spliced);
+	printf("cost_weight_suppl = %lf\n", cost_weight_suppl);
+	printf("cost_weight_span = %lf\n", cost_weight_span);
+	printf("bundle_cost_file = %s\n", bundle_cost_file.c_str());
+	printf("profile_file = %s\n", profile_file.c_str());
+	printf("profile_top = %d\n", profile_top);
+	printf("metrics_file = %s\n", metrics_file.c_str());
+	printf("metrics_interval = %lf\n", metrics_interval);
 	printf("fa_parameter = %d\n", fa_parameter);
 	printf("fe_parameter = %d\n", fe_parameter);
 	printf("r_parametetr = %d\n", r_parameter);
@@ -523,6 +678,7 @@ int print_parameters()
 	printf("ref_file = %s\n", ref_file.c_str());
 	printf("fasta_file = %s\n", fasta_file.c_str());
 	printf("feature_file = %s\n", feature_file.c_str());
+	printf("read_assignment_file = %s\n", read_assignment_file.c_str());
 	// printf("ref_file1 = %s\n", ref_file1.c_str());
 	// printf("ref_file2 = %s\n", ref_file2.c_str());
 	// printf("output_file1 = %s\n", output_file1.c_str());
@@ -534,6 +690,7 @@ int print_parameters()
 	// printf("uniquely_mapped_only = %c\n", uniquely_mapped_only ? 'T' : 'F');
 	// printf("verbose = %d\n", verbose);
 	// printf("batch_bundle_size = %d\n", batch_bundle_size);
+	printf("num_threads = %d\n", num_threads);
 
 	printf("\n");
 
@@ -563,6 +720,12 @@ int print_help()
 	//printf(" %-42s  %s\n", "--verbose <0, 1, 2>",  "0: quiet; 1: one line for each graph; 2: with details, default: 1");
 	//printf(" %-42s  %s\n", "-f/--transcript_fragments <filename>",  "file to which the assembled non-full-length transcripts will be written to");
 	printf(" %-42s  %s\n", "--library_type <empty, unstranded, first, second>",  "library type of the sample, default: empty");
+	printf(" %-42s  %s\n", "--bsj-only <true, false>",  "only report back-splice junctions with read counts (BED) to -o, default: false");
+	printf(" %-42s  %s\n", "--profile_file <filename>",  "file to which per-stage time and counters of each bundle will be written to (TSV, JSON if *.json)");
+	printf(" %-42s  %s\n", "--profile_top <integer>",  "number of slowest bundles summarized at exit when profiling, default: 10");
+	printf(" %-42s  %s\n", "--metrics <filename>",  "file to which run metrics will be written to (JSON), periodically and at exit");
+	printf(" %-42s  %s\n", "--threads <integer>",  "number of threads for post-processing circRNAs of different chromosomes, default: 1");
+	printf(" %-42s  %s\n", "--read_assignment_file <filename>",  "file to which supporting reads of each circRNA will be written to");
 	//printf(" %-42s  %s\n", "--min_transcript_coverage <float>",  "minimum coverage required for a multi-exon transcript, default: 1.5");
 	//printf(" %-42s  %s\n", "--min_single_exon_coverage <float>",  "minimum coverage required for a single-exon transcript, default: 20");
 	//printf(" %-42s  %s\n", "--min_transcript_length_increase <integer>",  "default: 50");
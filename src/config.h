@@ -79,6 +79,11 @@ extern int max_edit_distance;
 extern int32_t min_bundle_gap;
 extern int min_num_hits_in_bundle;
 extern int min_num_splices_in_bundle;
+extern bool use_evidence_gate;
+extern bool split_bundles;
+extern int max_bundle_hits;
+extern bool collapse_duplicate_fragments;
+extern bool umi_dedup;
 extern uint32_t min_mapping_quality;
 extern int32_t min_splice_boundary_hits;
 extern bool uniquely_mapped_only;
@@ -138,10 +143,31 @@ extern string output_file;
 extern string output_file1;
 extern string output_circ_file;
 extern string cirifull_file;
+extern int ro_bloom_bits;
 extern string feature_file;
+extern string read_assignment_file;
+
+// for targeted assembly
+extern bool targeted_assembly;
+extern int32_t targeted_window;
+
+// for bsj-only mode
+extern bool bsj_only;
+
+// for bundle cost estimation
+extern double cost_weight_hit;
+extern double cost_weight_spliced;
+extern double cost_weight_suppl;
+extern double cost_weight_span;
+extern string bundle_cost_file;
+extern string profile_file;
+extern int profile_top;
+extern string metrics_file;
+extern double metrics_interval;
 
 // for controling
 extern int batch_bundle_size;
+extern int num_threads;
 extern int verbose;
 extern string version;
 
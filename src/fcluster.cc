@@ -34,7 +34,15 @@ int fcluster::add_phase(const vector<int> &v)
 	return 0;
 }
 
-const vector<int> & fcluster::get_vlist() const
+int fcluster::weight() const
+{
+	// number of read pairs, counting collapsed duplicates
+	int w = 0;
+	for(int i = 0; i < fset.size(); i++) w += fset[i]->cnt;
+	return w;
+}
+
+const small_vector<int, 8> & fcluster::get_vlist() const
 {
 	if(type == 0) return v0;
 	if(type == 1) return v1;
@@ -48,9 +56,9 @@ int fcluster::print(int index) const
 	printf("fcluster %d: type = %d, #fragments = %lu, #phase = %lu, ", index, type, fset.size(), phase.size());
 
 	printf("  v1 = ( ");
-	printv(v1);
+	printv(vector<int>(v1.begin(), v1.end()));
 	printf("), v2 = ( ");
-	printv(v2);
+	printv(vector<int>(v2.begin(), v2.end()));
 	printf(")\n");
 
 	for(int k = 0; k < phase.size(); k++)
@@ -65,8 +73,8 @@ int fcluster::print(int index) const
 
 bool compare_fcluster(const fcluster &fx, const fcluster &fy)
 {
-	const vector<int> &vx = fx.get_vlist();
-	const vector<int> &vy = fy.get_vlist();
+	const small_vector<int, 8> &vx = fx.get_vlist();
+	const small_vector<int, 8> &vy = fy.get_vlist();
 
 	for(int k = 0; k < vx.size() && k < vy.size(); k++)
 	{
@@ -10,6 +10,7 @@ See LICENSE for licensing.
 #include <vector>
 #include "path.h"
 #include "fragment.h"
+#include "small_vector.h"
 
 using namespace std;
 
@@ -18,9 +19,9 @@ class fcluster
 public:
 	vector<fragment*> fset;			// set of fragments in this cluster
 	int type;						// for multiple uses
-	vector<int> v0;					// vlist for closed fragments
-	vector<int> v1;					// vlist for mate1
-	vector<int> v2;					// vlist for mate2
+	small_vector<int, 8> v0;		// vlist for closed fragments
+	small_vector<int, 8> v1;		// vlist for mate1
+	small_vector<int, 8> v2;		// vlist for mate2
 	vector< vector<int> > phase;	// possible phasing w.r.t. reference
 	vector<int> count;				// phase count
 
@@ -28,7 +29,8 @@ public:
 	int clear();
 	int print(int k) const;
 	int add_phase(const vector<int> &v);
-	const vector<int> & get_vlist() const;
+	int weight() const;
+	const small_vector<int, 8> & get_vlist() const;
 };
 
 bool compare_fcluster(const fcluster &fx, const fcluster &fy);
@@ -32,6 +32,7 @@ fragment::fragment(hit *x1, hit *x2)
 	lpos = -1;
 	rpos = -1;
 	cnt = 1;
+	umi_cnt = 1;
 	paths.clear();
 }
 
@@ -69,6 +70,7 @@ int fragment::clear()
 	lpos = -1;
 	rpos = -1;
 	cnt = 1;
+	umi_cnt = 1;
 	return 0;
 }
 
@@ -37,6 +37,7 @@ public:
 	int candidate_path_count; //number of candidate paths from pick_bridge path
 
 	int cnt;			// count of the equal hits
+	int umi_cnt;		// number of reads of the UMI molecule this fragment represents
 	int32_t lpos;		// equals to hits[k1].pos
 	int32_t rpos;		// equals to hits[k2].rpos
 	int32_t k1l;		// k1-left-outside length
@@ -45,6 +45,7 @@ hit::hit()
 	hid = 0;
 	qname = "";
 	qhash = 0;
+	qid = -1;
 	paired = false;
 	bridged = false;
 	next = NULL;
@@ -53,6 +54,7 @@ hit::hit()
 	supple_pos = 0;
 	is_reverse_overlap = false;
 	is_fake = false;
+	is_carried = false;
 	fake_hit_index = -1;
 	soft_clip_side = 0;
 	
@@ -116,6 +118,7 @@ hit& hit::operator=(const hit &h)
 	suppl = h.suppl;
 	is_reverse_overlap = h.is_reverse_overlap;
 	is_fake = h.is_fake;
+	is_carried = h.is_carried;
 	fake_hit_index = h.fake_hit_index;
 	soft_clip_side = h.soft_clip_side;
 	tiny_boundary = h.tiny_boundary;
@@ -129,6 +132,7 @@ hit& hit::operator=(const hit &h)
 	paired = h.paired;
 	bridged = h.bridged;
 	qhash = h.qhash;
+	qid = h.qid;
 	next = h.next;
 
 	umi = h.umi;
@@ -170,6 +174,7 @@ hit::hit(const hit &h)
 	supple_pos = h.supple_pos;
 	is_reverse_overlap = h.is_reverse_overlap;
 	is_fake = h.is_fake;
+	is_carried = h.is_carried;
 	fake_hit_index = h.fake_hit_index;
 	soft_clip_side = h.soft_clip_side;
 	suppl = h.suppl;
@@ -184,6 +189,7 @@ hit::hit(const hit &h)
 	paired = h.paired;
 	bridged = h.bridged;
 	qhash = h.qhash;
+	qid = h.qid;
 	next = h.next;
 
 	umi = h.umi;
@@ -210,7 +216,8 @@ hit::hit(bam1_t *b, int id)
 {
 	// fetch query name
 	qname = get_qname(b);
-	qhash = string_hash(qname);
+	qhash = get_qhash(b);
+	qid = -1;
 	paired = false;
 	bridged = false;
 	next = NULL;
@@ -219,6 +226,7 @@ hit::hit(bam1_t *b, int id)
 	supple_pos = 0;
 	is_reverse_overlap = false;
 	is_fake = false;
+	is_carried = false;
 	fake_hit_index = -1;
 	soft_clip_side = 0;
 	
@@ -243,101 +251,22 @@ hit::hit(bam1_t *b, int id)
 	soft_left_clip_seqs.clear();
 	soft_right_clip_seqs.clear();
 
-	// compute rpos
-	rpos = pos + (int32_t)bam_cigar2rlen(n_cigar, bam_get_cigar(b));
-	qlen = (int32_t)bam_cigar2qlen(n_cigar, bam_get_cigar(b));
-	//printf("rpos = %d, qlen = %d\n", rpos, qlen);
-
-	/*if(strcmp(qname.c_str(),"SRR1721290.17627808") == 0)
-	{
-		print();
-	}*/
-
-	//print();
-
 	// get cigar
 	assert(n_cigar <= max_num_cigar);
 	assert(n_cigar >= 1);
 	uint32_t * cigar = bam_get_cigar(b); //commented by Tasfia
 
-	// build splice positions
-	spos.clear();
-	int32_t p = pos;
-	int32_t q = 0;
-
-	//printf("qname: %s, n_cigar size: %d\n",qname.c_str(),n_cigar);
+	// decode cigar in a single pass: rpos, qlen, splice positions,
+	// cigar_vector and the matched/insert/delete intervals (scallop+coral)
+	decode_cigar(cigar, n_cigar);
+	//printf("rpos = %d, qlen = %d\n", rpos, qlen);
 
-    for(int k = 0; k < n_cigar; k++)
+	/*if(strcmp(qname.c_str(),"SRR1721290.17627808") == 0)
 	{
-		/* bam_cigar_type returns a bit flag with:
- *   bit 1 set if the cigar operation consumes the query
- *   bit 2 set if the cigar operation consumes the reference/**/
-
-		if (bam_cigar_type(bam_cigar_op(cigar[k]))&2)
-			p += bam_cigar_oplen(cigar[k]);
-		//printf("p=%d,",p);	
-
-		if (bam_cigar_type(bam_cigar_op(cigar[k]))&1)
-			q += bam_cigar_oplen(cigar[k]);
-		//printf("q=%d,",q);
-
-		//printf("cigar size = %d\n",bam_cigar_op(cigar[0]));
-
-		if(k == 0 || k == n_cigar - 1) continue;
-		if(bam_cigar_op(cigar[k]) != BAM_CREF_SKIP) continue; //BAM_CREF_SKIP junction
-		if(bam_cigar_op(cigar[k-1]) != BAM_CMATCH) continue; //match
-		if(bam_cigar_op(cigar[k+1]) != BAM_CMATCH) continue; //match
-
-		// consider ALL splice positions
-		//if(bam_cigar_oplen(cigar[k-1]) < min_flank_length) continue;
-		//if(bam_cigar_oplen(cigar[k+1]) < min_flank_length) continue;
-		//printf("\nPassed conditions of spos\n");
-
-		int32_t s = p - bam_cigar_oplen(cigar[k]);
-		//printf("s=%d\n",s);
-		spos.push_back(pack(s, p));
-
-	}
-
-	cigar_vector.clear();
+		print();
+	}*/
 
-	for(int k = 0; k < n_cigar; k++)
-	{
-		if(bam_cigar_op(cigar[k]) == BAM_CMATCH)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('M',bam_cigar_oplen(cigar[k])));
-		}
-		else if(bam_cigar_op(cigar[k]) == BAM_CSOFT_CLIP)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('S',bam_cigar_oplen(cigar[k])));
-		}
-		else if(bam_cigar_op(cigar[k]) == BAM_CHARD_CLIP)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('H',bam_cigar_oplen(cigar[k])));
-		}
-		else if(bam_cigar_op(cigar[k]) == BAM_CREF_SKIP)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('N',bam_cigar_oplen(cigar[k])));
-		}
-		else if(bam_cigar_op(cigar[k]) == BAM_CINS)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('I',bam_cigar_oplen(cigar[k])));
-		}
-		else if(bam_cigar_op(cigar[k]) == BAM_CDEL)
-		{
-			cigar_vector.push_back(pair<char, int32_t>('D',bam_cigar_oplen(cigar[k])));
-		}
-		else
-		{
-			cigar_vector.push_back(pair<char, int32_t>('.',0));
-		}
-	}
-	
-	//putting a placeholder to avoid core dumped when cigar_vector[0] is accessed
-	if(cigar_vector.size() == 0)
-	{
-		cigar_vector.push_back(pair<char, int32_t>('.',0));
-	}
+	//print();
 
 	//assign booleans to see if left splice position H/S and right M or vie versa and stor their lengths
 	/*if(n_cigar == 2)
@@ -389,40 +318,62 @@ hit::hit(bam1_t *b, int id)
 	}*/
 
 
-	//printf("spos size: %d\n", spos.size());
+	//printf("call regular constructor\n");
+	//printf("end ...................................\n");
+}
+
+// cigar op -> character stored in cigar_vector ('.' for ops not tracked)
+static const char cigar_op_char[16] = {'M', 'I', 'D', 'N', 'S', 'H', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.'};
+
+// cigar op -> bit 1: consumes query, bit 2: consumes reference
+static const uint8_t cigar_op_type[16] = {3, 1, 2, 2, 1, 0, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0};
 
-	// open for scallop+coral
+int hit::decode_cigar(const uint32_t *cigar, int n)
+{
+	spos.clear();
+	cigar_vector.clear();
 	itvm.clear();
 	itvi.clear();
 	itvd.clear();
-	p = pos;
-    for(int k = 0; k < n_cigar; k++)
+	cigar_vector.reserve(n);
+
+	int32_t p = pos;
+	int32_t q = 0;
+	for(int k = 0; k < n; k++)
 	{
-		if (bam_cigar_type(bam_cigar_op(cigar[k]))&2)
-		{
-			p += bam_cigar_oplen(cigar[k]);
-		}
+		int op = bam_cigar_op(cigar[k]);
+		int32_t len = bam_cigar_oplen(cigar[k]);
+		uint8_t t = cigar_op_type[op];
 
-		if(bam_cigar_op(cigar[k]) == BAM_CMATCH)
-		{
-			int32_t s = p - bam_cigar_oplen(cigar[k]);
-			itvm.push_back(pack(s, p));
-		}
+		if(t & 2) p += len;
+		if(t & 1) q += len;
 
-		if(bam_cigar_op(cigar[k]) == BAM_CINS)
-		{
-			itvi.push_back(pack(p - 1, p + 1));
-		}
+		char c = cigar_op_char[op];
+		if(c == '.') cigar_vector.push_back(pair<char, int32_t>('.', 0));
+		else cigar_vector.push_back(pair<char, int32_t>(c, len));
 
-		if(bam_cigar_op(cigar[k]) == BAM_CDEL)
+		if(op == BAM_CMATCH) itvm.push_back(pack(p - len, p));
+		else if(op == BAM_CINS) itvi.push_back(pack(p - 1, p + 1));
+		else if(op == BAM_CDEL) itvd.push_back(pack(p - len, p));
+		else if(op == BAM_CREF_SKIP)
 		{
-			int32_t s = p - bam_cigar_oplen(cigar[k]);
-			itvd.push_back(pack(s, p));
+			// consider ALL splice positions flanked by matches
+			if(k == 0 || k == n - 1) continue;
+			if(bam_cigar_op(cigar[k - 1]) != BAM_CMATCH) continue;
+			if(bam_cigar_op(cigar[k + 1]) != BAM_CMATCH) continue;
+			spos.push_back(pack(p - len, p));
 		}
 	}
 
-	//printf("call regular constructor\n");
-	//printf("end ...................................\n");
+	//putting a placeholder to avoid core dumped when cigar_vector[0] is accessed
+	if(cigar_vector.size() == 0)
+	{
+		cigar_vector.push_back(pair<char, int32_t>('.',0));
+	}
+
+	rpos = p;
+	qlen = q;
+	return 0;
 }
 
 int hit::get_aligned_intervals(vector<int64_t> &v) const
@@ -441,12 +392,15 @@ int hit::get_aligned_intervals(vector<int64_t> &v) const
 
 string hit::get_qname(bam1_t *b)
 {
-	char buf[1024];
 	char *q = bam_get_qname(b);
-	int l = strlen(q);
-	memcpy(buf, q, l);
-	buf[l] = '\0';
-	return string(buf);
+	return string(q, strlen(q));
+}
+
+size_t hit::get_qhash(bam1_t *b)
+{
+	// hash the name bytes in place, without copying to a string
+	char *q = bam_get_qname(b);
+	return bytes_hash(q, strlen(q));
 }
 
 string hit::convert_to_IUPAC(vector<int> code)
@@ -617,15 +571,96 @@ string hit::get_complement(string str)
 	return out;
 }
 
+// size in bytes of a fixed-size aux value of type t, 0 otherwise
+static inline int aux_type_size(uint8_t t)
+{
+	switch(t)
+	{
+		case 'A': case 'c': case 'C': return 1;
+		case 's': case 'S': return 2;
+		case 'i': case 'I': case 'f': return 4;
+		case 'd': return 8;
+		default: return 0;
+	}
+}
+
+int hit::scan_aux_tags(bam1_t *b, uint8_t **tags)
+{
+	// locate ts, XS, HI, NH, nM, NM, UB and SA in a single pass over the aux block;
+	// tags[k] points to the type byte (as bam_aux_get) or NULL if absent
+	static const char names[AUX_TAG_NUM][2] = {{'t','s'}, {'X','S'}, {'H','I'}, {'N','H'}, {'n','M'}, {'N','M'}, {'U','B'}, {'S','A'}};
+
+	for(int k = 0; k < AUX_TAG_NUM; k++) tags[k] = NULL;
+
+	uint8_t *s = bam_get_aux(b);
+	uint8_t *e = b->data + b->l_data;
+	int found = 0;
+
+	while(s + 3 <= e && found < AUX_TAG_NUM)
+	{
+		uint8_t *t = s + 2;
+		for(int k = 0; k < AUX_TAG_NUM; k++)
+		{
+			if(s[0] != names[k][0] || s[1] != names[k][1]) continue;
+			if(tags[k] != NULL) break;
+			tags[k] = t;
+			found++;
+			break;
+		}
+
+		// skip the value
+		uint8_t type = *t;
+		s = t + 1;
+		int z = aux_type_size(type);
+		if(z > 0)
+		{
+			s += z;
+		}
+		else if(type == 'Z' || type == 'H')
+		{
+			while(s < e && *s != 0) s++;
+			s++;
+		}
+		else if(type == 'B')
+		{
+			if(s + 5 > e) break;
+			int zb = aux_type_size(s[0]);
+			uint32_t n;
+			memcpy(&n, s + 1, 4);
+			if(zb == 0) break;
+			s += 5 + (int64_t)zb * n;
+		}
+		else break;
+	}
+	return found;
+}
+
+// parse the reference position (second field) of an SA:Z value "chr,pos,strand,cigar,mapq,nm;..."
+static inline int32_t parse_sa_pos(const char *p)
+{
+	while(*p != 0 && *p != ',') p++;
+	if(*p != ',') return 0;
+	p++;
+
+	bool neg = false;
+	if(*p == '-' || *p == '+') neg = (*p++ == '-');
+	int32_t v = 0;
+	while(*p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+	return neg ? -v : v;
+}
+
 int hit::set_tags(bam1_t *b)
 {
+	uint8_t *tags[AUX_TAG_NUM];
+	scan_aux_tags(b, tags);
+
 	ts = '.';
-	uint8_t *p0 = bam_aux_get(b, "ts"); //ts used by minimap2
+	uint8_t *p0 = tags[AUX_TAG_TS]; //ts used by minimap2
 	if(p0 && (*p0) == 'A') ts = bam_aux2A(p0);
 	if(p0 && (*p0) == 'a') ts = bam_aux2A(p0);
 
 	xs = '.';
-	uint8_t *p1 = bam_aux_get(b, "XS"); //used by star and hisat
+	uint8_t *p1 = tags[AUX_TAG_XS]; //used by star and hisat
 	if(p1 && (*p1) == 'A') xs = bam_aux2A(p1);
 	if(p1 && (*p1) == 'a') xs = bam_aux2A(p1);
 
@@ -639,59 +674,45 @@ int hit::set_tags(bam1_t *b)
 	}
 
 	hi = -1;
-	uint8_t *p2 = bam_aux_get(b, "HI");
+	uint8_t *p2 = tags[AUX_TAG_HI];
 	if(p2 && (*p2) == 'C') hi = bam_aux2i(p2);
 	if(p2 && (*p2) == 'c') hi = bam_aux2i(p2);
 
 	nh = -1;
-	uint8_t *p3 = bam_aux_get(b, "NH");
+	uint8_t *p3 = tags[AUX_TAG_NH];
 	if(p3 && (*p3) == 'C') nh = bam_aux2i(p3);
 	if(p3 && (*p3) == 'c') nh = bam_aux2i(p3);
 
 	nm = 0;
-	uint8_t *p4 = bam_aux_get(b, "nM");
+	uint8_t *p4 = tags[AUX_TAG_nM];
 	if(p4 && (*p4) == 'C') nm = bam_aux2i(p4);
 	if(p4 && (*p4) == 'c') nm = bam_aux2i(p4);
 
-	uint8_t *p5 = bam_aux_get(b, "NM");
+	uint8_t *p5 = tags[AUX_TAG_NM];
 	if(p5 && (*p5) == 'C') nm = bam_aux2i(p5);
 	if(p5 && (*p5) == 'c') nm = bam_aux2i(p5);
 
 	// set umi
 	umi = "";
-	uint8_t *p6 = bam_aux_get(b, "UB");
+	uint8_t *p6 = tags[AUX_TAG_UB];
 	if(p6 && (*p6) == 'H') umi = bam_aux2Z(p6);
 	if(p6 && (*p6) == 'Z') umi = bam_aux2Z(p6);
 
 	sa = "";
-	uint8_t *p7 = bam_aux_get(b, "SA"); //sa tag has the supple pos and cigar of curr hit, ex: SA:Z:chr1,14068602,+,51M99H,255,0;
-	if(p7 && (*p7) == 'Z') sa = bam_aux2Z(p7);
-	if(p7 && (*p7) == 'z') sa = bam_aux2Z(p7);
-
-	//printf("umi tag:%s\n",umi.c_str());
-	//printf("sa tag:%s\n",sa.c_str());
-
-	string sa_tag = sa.c_str();
-
-	vector<string> results;
-	stringstream  ss(sa_tag);
-	string str;
-	while (getline(ss, str, ',')) {
-		results.push_back(str);
-	}
-
-	if(results.size() > 0)
+	uint8_t *p7 = tags[AUX_TAG_SA]; //sa tag has the supple pos and cigar of curr hit, ex: SA:Z:chr1,14068602,+,51M99H,255,0;
+	if(p7 && ((*p7) == 'Z' || (*p7) == 'z'))
 	{
-		/*for(int i=0;i<results.size();i++)
+		const char *z = bam_aux2Z(p7);
+		if(z != NULL)
 		{
-			printf("%s ",results[i].c_str());
+			sa = z;
+			supple_pos = parse_sa_pos(z);
+			//printf("supple_pos = %d\n",supple_pos);
 		}
-		printf("\n");*/
-
-		supple_pos = atoi(results[1].c_str());
-		//printf("supple_pos = %d\n",supple_pos);
 	}
 
+	//printf("umi tag:%s\n",umi.c_str());
+	//printf("sa tag:%s\n",sa.c_str());
 
 	/*	
 	// TODO: check if UB = UX
@@ -841,11 +862,35 @@ vector<int> encode_vlist(const vector<int> &v)
 vector<int> decode_vlist(const vector<int> &v)
 {
 	vector<int> vv;
+	decode_vlist(v.data(), v.size(), vv);
+	return vv;
+}
+
+vector<int> decode_vlist(const small_vector<int, 6> &v)
+{
+	vector<int> vv;
+	decode_vlist(v.data(), v.size(), vv);
+	return vv;
+}
+
+int decode_vlist(const vector<int> &v, vector<int> &vv)
+{
+	return decode_vlist(v.data(), v.size(), vv);
+}
+
+int decode_vlist(const small_vector<int, 6> &v, vector<int> &vv)
+{
+	return decode_vlist(v.data(), v.size(), vv);
+}
+
+int decode_vlist(const int *v, int n, vector<int> &vv)
+{
+	// decode into vv, reusing its capacity
 	vv.clear();
-	assert(v.size() % 2 == 0);
-	if(v.size() <= 0) return vv;
+	assert(n % 2 == 0);
+	if(n <= 0) return 0;
 
-	for(int i = 0; i < v.size() / 2; i++)
+	for(int i = 0; i < n / 2; i++)
 	{
 		int p = v[i * 2 + 0];
 		int k = v[i * 2 + 1];
@@ -854,5 +899,5 @@ vector<int> decode_vlist(const vector<int> &v)
 			vv.push_back(j);
 		}
 	}
-	return vv;
+	return 0;
 }
@@ -18,9 +18,20 @@ See LICENSE for licensing.
 
 #include "htslib/sam.h"
 #include "config.h"
+#include "small_vector.h"
 
 using namespace std;
 
+// aux tags decoded by hit::set_tags, indices into the result of hit::scan_aux_tags
+#define AUX_TAG_TS 0
+#define AUX_TAG_XS 1
+#define AUX_TAG_HI 2
+#define AUX_TAG_NH 3
+#define AUX_TAG_nM 4
+#define AUX_TAG_NM 5
+#define AUX_TAG_UB 6
+#define AUX_TAG_SA 7
+#define AUX_TAG_NUM 8
 
 /*! @typedef
  @abstract Structure for core alignment information.
@@ -69,13 +80,13 @@ public:
 	int32_t first_pos;						//.H.M. the three dots are the 1st, 2nd, and 3rd pos respectively
 	int32_t second_pos;
 	int32_t third_pos;
-	vector<pair<char, int32_t>> cigar_vector; 	//stores all cigars of a hit with length
+	small_vector<pair<char, int32_t>, 5> cigar_vector; 	//stores all cigars of a hit with length
 	int32_t tiny_boundary;
 
 
 	//vector<uint32_t> cigar_positions;		// stores putative back splice positions
-	vector<int64_t> spos;					// splice positions
-	vector<int> vlist;						// list of spanned vertices in the junction graph
+	small_vector<int64_t, 2> spos;			// splice positions
+	small_vector<int, 6> vlist;				// list of spanned vertices in the junction graph
 	int32_t rpos;							// right position mapped to reference [pos, rpos)
 	int32_t qlen;							// read length
 	int32_t nh;								// NH aux in sam
@@ -85,15 +96,17 @@ public:
 	int32_t supple_pos;						// stores position of supple from SA tag
 	bool is_reverse_overlap;				// whether this is a RO read
 	size_t qhash;							// hash code for qname
+	int qid;								// dense id of qname within the bundle, -1 if not interned
 	hit *suppl;								// supplementary hit
 	bool is_fake;							// whether this is a fake hit
+	bool is_carried;						// whether this hit was handed over from an earlier bundle
 	int fake_hit_index; 					//used to keep track of fragment for which fake hit is created, stores index of partner fragment
 	int soft_clip_side;						//used to keep track of whether the fake hit comes from a soft left clip (1) or soft right clip (2)
 
 	// scallop+coral
-	vector<int64_t> itvm;					// matched interval
-	vector<int64_t> itvi;					// insert interval
-	vector<int64_t> itvd;					// delete interval
+	small_vector<int64_t, 3> itvm;			// matched interval
+	small_vector<int64_t, 1> itvi;			// insert interval
+	small_vector<int64_t, 1> itvd;			// delete interval
 
 	bool concordant;						// whether it is concordant
 	bool paired;							// whether this hit has been paired
@@ -115,12 +128,15 @@ public:
 
 public:
  	static string get_qname(bam1_t *b);
+	static size_t get_qhash(bam1_t *b);
 	string get_reverse_complement(string str);
 	string get_complement(string str);
 	string convert_to_IUPAC(vector<int> code);
 	int set_soft_clip_seq_combo();
 	int set_seq(bam1_t *b);
+	int decode_cigar(const uint32_t *cigar, int n);
 	int set_tags(bam1_t *b);
+	static int scan_aux_tags(bam1_t *b, uint8_t **tags);
 	int set_strand();
 	int set_concordance();
 	int get_aligned_intervals(vector<int64_t> &v) const;
@@ -130,6 +146,10 @@ public:
 
 vector<int> encode_vlist(const vector<int> &v);
 vector<int> decode_vlist(const vector<int> &v);
+vector<int> decode_vlist(const small_vector<int, 6> &v);
+int decode_vlist(const vector<int> &v, vector<int> &vv);
+int decode_vlist(const small_vector<int, 6> &v, vector<int> &vv);
+int decode_vlist(const int *v, int n, vector<int> &vv);
 
 //inline bool hit_compare_by_name(const hit &x, const hit &y);
 
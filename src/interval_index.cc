@@ -0,0 +1,171 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include "interval_index.h"
+
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+
+interval_index::interval_index()
+{
+	max_level = -1;
+	indexed = false;
+}
+
+int interval_index::clear()
+{
+	records.clear();
+	max_level = -1;
+	indexed = false;
+	return 0;
+}
+
+int interval_index::add(int32_t l, int32_t r, int v)
+{
+	if(l >= r) return 0;
+	interval_record x;
+	x.lpos = l;
+	x.rpos = r;
+	x.maxr = r;
+	x.value = v;
+	records.push_back(x);
+	indexed = false;
+	return 0;
+}
+
+int interval_index::index()
+{
+	sort(records.begin(), records.end(), compare_interval_record);
+	indexed = true;
+
+	int64_t n = records.size();
+	max_level = -1;
+	if(n <= 0) return 0;
+
+	// leaves sit at even positions; node i at level k has (k) trailing 1 bits
+	int64_t last_i = 0;
+	int32_t last = 0;
+	for(int64_t i = 0; i < n; i += 2)
+	{
+		records[i].maxr = records[i].rpos;
+		last_i = i;
+		last = records[i].maxr;
+	}
+
+	int k = 1;
+	for(; ((int64_t)1 << k) <= n; k++)
+	{
+		int64_t x = (int64_t)1 << (k - 1);
+		int64_t i0 = (x << 1) - 1;
+		int64_t step = x << 2;
+		for(int64_t i = i0; i < n; i += step)
+		{
+			int32_t el = records[i - x].maxr;
+			int32_t er = (i + x < n) ? records[i + x].maxr : last;
+			int32_t e = records[i].rpos;
+			if(el > e) e = el;
+			if(er > e) e = er;
+			records[i].maxr = e;
+		}
+		last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+		if(last_i < n && records[last_i].maxr > last) last = records[last_i].maxr;
+	}
+
+	max_level = k - 1;
+	return 0;
+}
+
+int interval_index::overlap(int32_t x, int32_t y, vector<int> &v) const
+{
+	// collect values of all records with lpos < y and rpos > x;
+	// results are appended to v in ascending order of value
+	assert(indexed == true);
+
+	size_t m = v.size();
+	int64_t n = records.size();
+	if(x >= y || n <= 0) return 0;
+
+	int64_t sx[64];
+	int sk[64];
+	bool sw[64];
+	int t = 0;
+
+	sk[t] = max_level;
+	sx[t] = ((int64_t)1 << max_level) - 1;
+	sw[t] = false;
+	t++;
+
+	while(t > 0)
+	{
+		t--;
+		int64_t zx = sx[t];
+		int zk = sk[t];
+		bool zw = sw[t];
+
+		if(zk <= 3)
+		{
+			// small subtree: linear scan
+			int64_t i0 = zx >> zk << zk;
+			int64_t i1 = i0 + ((int64_t)1 << (zk + 1)) - 1;
+			if(i1 > n) i1 = n;
+			for(int64_t i = i0; i < i1 && records[i].lpos < y; i++)
+			{
+				if(records[i].rpos > x) v.push_back(records[i].value);
+			}
+		}
+		else if(zw == false)
+		{
+			// revisit this node after its left child
+			int64_t lc = zx - ((int64_t)1 << (zk - 1));
+			sk[t] = zk;
+			sx[t] = zx;
+			sw[t] = true;
+			t++;
+			if(lc >= n || records[lc].maxr > x)
+			{
+				sk[t] = zk - 1;
+				sx[t] = lc;
+				sw[t] = false;
+				t++;
+			}
+		}
+		else if(zx < n && records[zx].lpos < y)
+		{
+			if(records[zx].rpos > x) v.push_back(records[zx].value);
+			sk[t] = zk - 1;
+			sx[t] = zx + ((int64_t)1 << (zk - 1));
+			sw[t] = false;
+			t++;
+		}
+	}
+
+	sort(v.begin() + m, v.end());
+	return v.size() - m;
+}
+
+int interval_index::size() const
+{
+	return records.size();
+}
+
+int interval_index::print() const
+{
+	for(int i = 0; i < records.size(); i++)
+	{
+		const interval_record &r = records[i];
+		printf("[%d, %d) -> %d (max = %d)\n", r.lpos, r.rpos, r.value, r.maxr);
+	}
+	return 0;
+}
+
+bool compare_interval_record(const interval_record &a, const interval_record &b)
+{
+	if(a.lpos < b.lpos) return true;
+	if(a.lpos > b.lpos) return false;
+	if(a.rpos < b.rpos) return true;
+	if(a.rpos > b.rpos) return false;
+	return a.value < b.value;
+}
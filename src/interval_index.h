@@ -0,0 +1,46 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __INTERVAL_INDEX_H__
+#define __INTERVAL_INDEX_H__
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+// half-open interval [lpos, rpos) with an associated value
+struct interval_record
+{
+	int32_t lpos;				// left boundary (inclusive)
+	int32_t rpos;				// right boundary (exclusive)
+	int32_t maxr;				// max rpos in the implicit subtree rooted here
+	int value;					// associated value (e.g., gene index)
+};
+
+// flat interval index: records sorted by lpos and augmented with
+// max-end in an implicit binary tree laid out in sorted order
+class interval_index
+{
+public:
+	interval_index();
+
+public:
+	vector<interval_record> records;	// sorted by lpos after index()
+	int max_level;						// level of the implicit root
+	bool indexed;						// whether index() has been called
+
+public:
+	int clear();
+	int add(int32_t l, int32_t r, int v);
+	int index();
+	int overlap(int32_t x, int32_t y, vector<int> &v) const;
+	int size() const;
+	int print() const;
+};
+
+bool compare_interval_record(const interval_record &a, const interval_record &b);
+
+#endif
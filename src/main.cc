@@ -12,6 +12,7 @@ See LICENSE for licensing.
 #include <ctime>
 #include <cassert>
 #include <sstream>
+#include <chrono>
 
 #include "config.h"
 #include "previewer.h"
@@ -47,12 +48,15 @@ int main(int argc, const char **argv)
 
 	reference ref(ref_file);
 
+	chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
 	previewer pv(ref); 
 	pv.preview(); //resolve strandness and estimate fragment length distirbution
+	double tp = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
 
 	if(preview_only == true) return 0;
 
 	assembler asmb(ref);
+	asmb.set_preview_time(tp);
 	asmb.assemble();
 
 	return 0;
@@ -0,0 +1,165 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <algorithm>
+
+#include "mate_stash.h"
+#include "util.h"
+
+mate_stash::mate_stash()
+{
+	tid = -1;
+}
+
+int mate_stash::clear()
+{
+	tid = -1;
+	hits.clear();
+	splices.clear();
+	return 0;
+}
+
+int mate_stash::add(const vector<hit> &v, int32_t rpos)
+{
+	// stash every hit of a read group under the nearest partner of any
+	// of its hits beyond rpos; a fragment or circ fragment needs the mate
+	// as well as the supplementary, so the group moves as a whole
+	if(v.size() == 0) return 0;
+	if(v[0].tid != tid) clear();
+	tid = v[0].tid;
+
+	vector<size_t> qh;
+	map<pair<size_t, string>, int32_t> m;		// read group -> nearest partner
+	for(int i = 0; i < v.size(); i++)
+	{
+		int32_t p = locate(v[i], rpos);
+		if(p == -1) continue;
+
+		pair<size_t, string> x(v[i].qhash, v[i].qname);
+		map<pair<size_t, string>, int32_t>::iterator it = m.find(x);
+		if(it == m.end()) m.insert(pair<pair<size_t, string>, int32_t>(x, p));
+		else if(p < it->second) it->second = p;
+		qh.push_back(v[i].qhash);
+	}
+	if(m.size() == 0)
+	{
+		prune_splices();
+		return 0;
+	}
+	sort(qh.begin(), qh.end());
+
+	int cnt = 0;
+	for(int i = 0; i < v.size(); i++)
+	{
+		if(binary_search(qh.begin(), qh.end(), v[i].qhash) == false) continue;
+		map<pair<size_t, string>, int32_t>::iterator it = m.find(pair<size_t, string>(v[i].qhash, v[i].qname));
+		if(it == m.end()) continue;
+		hits.insert(pair<int32_t, hit>(it->second, v[i]));
+		cnt++;
+	}
+
+	// receivers also need the junctions around the stashed hits
+	for(int i = 0; i < v.size(); i++)
+	{
+		if(v[i].spos.size() >= 1) splices.push_back(v[i]);
+	}
+	prune_splices();
+	return cnt;
+}
+
+int32_t mate_stash::locate(const hit &h, int32_t rpos) const
+{
+	// nearest partner of h (mate, or supplementary from SA, which is
+	// 1-based) that starts beyond rpos, i.e., in a later bundle
+	int32_t p = -1;
+	if(h.mtid == h.tid && h.mpos > rpos && h.mpos <= h.rpos + 1000000) p = h.mpos;
+	int32_t s = h.supple_pos - 1;
+	if(s > rpos && s <= h.rpos + 1000000 && (p == -1 || s < p)) p = s;
+	return p;
+}
+
+int mate_stash::resolve(const hit &h, vector<hit> &v)
+{
+	// move out stashed hits whose partner is h
+	if(h.tid != tid) return 0;
+
+	int cnt = 0;
+	pair<multimap<int32_t, hit>::iterator, multimap<int32_t, hit>::iterator> r = hits.equal_range(h.pos);
+	for(multimap<int32_t, hit>::iterator it = r.first; it != r.second; )
+	{
+		const hit &z = it->second;
+		if(z.qhash != h.qhash || z.qname != h.qname || z.strand != h.strand)
+		{
+			it++;
+			continue;
+		}
+		v.push_back(z);
+		hits.erase(it++);
+		cnt++;
+	}
+	return cnt;
+}
+
+int mate_stash::get_splices(int32_t l, int32_t r, vector<hit> &v) const
+{
+	// spliced hits with a splice site in [l, r]
+	for(int i = 0; i < splices.size(); i++)
+	{
+		const hit &h = splices[i];
+		bool b = false;
+		for(int k = 0; k < h.spos.size() && b == false; k++)
+		{
+			int32_t p1 = high32(h.spos[k]);
+			int32_t p2 = low32(h.spos[k]);
+			if(p1 >= l && p1 <= r) b = true;
+			if(p2 >= l && p2 <= r) b = true;
+		}
+		if(b == true) v.push_back(h);
+	}
+	return 0;
+}
+
+int mate_stash::prune_splices()
+{
+	// spliced hits left of every stashed hit cannot be near a carried hit
+	if(hits.size() == 0)
+	{
+		splices.clear();
+		return 0;
+	}
+
+	int32_t p = hits.begin()->second.pos;
+	for(multimap<int32_t, hit>::iterator it = hits.begin(); it != hits.end(); it++)
+	{
+		if(it->second.pos < p) p = it->second.pos;
+	}
+
+	int k = 0;
+	for(int i = 0; i < splices.size(); i++)
+	{
+		if(splices[i].rpos < p) continue;
+		if(k < i) splices[k] = splices[i];
+		k++;
+	}
+	splices.resize(k);
+	return 0;
+}
+
+int mate_stash::expire(int32_t _tid, int32_t pos)
+{
+	// partners are met in coordinate order; drop those already passed
+	if(_tid != tid)
+	{
+		clear();
+		return 0;
+	}
+	hits.erase(hits.begin(), hits.lower_bound(pos));
+	return 0;
+}
+
+int mate_stash::size() const
+{
+	return hits.size();
+}
@@ -0,0 +1,41 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __MATE_STASH_H__
+#define __MATE_STASH_H__
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "hit.h"
+
+using namespace std;
+
+// read groups (all hits of a qname) of flushed bundles with a mate or
+// supplementary further right; each group is handed to the bundle that
+// later receives that partner
+class mate_stash
+{
+public:
+	mate_stash();
+
+public:
+	int32_t tid;						// chromosome of the stashed hits
+	multimap<int32_t, hit> hits;		// expected position of the partner -> stashed hit
+	vector<hit> splices;				// spliced hits of bundles that stashed hits, junction evidence for receivers
+
+public:
+	int clear();
+	int add(const vector<hit> &v, int32_t rpos);
+	int32_t locate(const hit &h, int32_t rpos) const;
+	int resolve(const hit &h, vector<hit> &v);
+	int get_splices(int32_t l, int32_t r, vector<hit> &v) const;
+	int prune_splices();
+	int expire(int32_t _tid, int32_t pos);
+	int size() const;
+};
+
+#endif
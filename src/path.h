@@ -43,8 +43,8 @@ public:
 
 	int nf;				// 1: empty = true, non full length path; 0: empty = false, full length path
 
-	vector<region> path_regions;
-	vector<region> merged_regions;
+	vector<region_span> path_regions;
+	vector<region_span> merged_regions;
 	vector<pair<int32_t,int32_t>> junc_regions;
 	int exon_count;
 
@@ -0,0 +1,154 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include "profiler.h"
+
+const char *profile_stage_names[NUM_PROFILE_STAGES] =
+{
+	"build_supplementaries",
+	"build_junctions",
+	"build_regions",
+	"build_fragments",
+	"build_circ_fragments",
+	"get_more_chimeric",
+	"create_fake_fragments",
+	"bridge_normal_fragments",
+	"bridge_circ_fragments",
+	"join_circ_fragment_pairs",
+	"total"
+};
+
+bundle_profile::bundle_profile()
+{
+	lpos = 0;
+	rpos = 0;
+	strand = '.';
+	hits = 0;
+	junctions = 0;
+	regions = 0;
+	fragments = 0;
+	circ_fragments = 0;
+	path_nodes = 0;
+	dp_cells = 0;
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) seconds[i] = 0;
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) allocations[i] = 0;
+}
+
+int bundle_profile::write_tsv_header(ostream &fout)
+{
+	fout << "chrm\tlpos\trpos\tstrand\thits\tjunctions\tregions\tfragments\tcirc_fragments\tpath_nodes\tdp_cells";
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) fout << "\t" << profile_stage_names[i];
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) fout << "\t" << profile_stage_names[i] << "_allocations";
+	fout << "\n";
+	return 0;
+}
+
+int bundle_profile::write_tsv(ostream &fout) const
+{
+	fout << chrm.c_str() << "\t" << lpos << "\t" << rpos << "\t" << strand << "\t";
+	fout << hits << "\t" << junctions << "\t" << regions << "\t" << fragments << "\t" << circ_fragments << "\t";
+	fout << path_nodes << "\t" << dp_cells;
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) fout << "\t" << seconds[i];
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++) fout << "\t" << allocations[i];
+	fout << "\n";
+	return 0;
+}
+
+int bundle_profile::write_json(ostream &fout) const
+{
+	fout << "{\"chrm\": \"" << chrm.c_str() << "\", \"lpos\": " << lpos << ", \"rpos\": " << rpos << ", \"strand\": \"" << strand << "\", ";
+	fout << "\"hits\": " << hits << ", \"junctions\": " << junctions << ", \"regions\": " << regions << ", ";
+	fout << "\"fragments\": " << fragments << ", \"circ_fragments\": " << circ_fragments << ", ";
+	fout << "\"path_nodes\": " << path_nodes << ", \"dp_cells\": " << dp_cells << ", \"seconds\": {";
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++)
+	{
+		if(i >= 1) fout << ", ";
+		fout << "\"" << profile_stage_names[i] << "\": " << seconds[i];
+	}
+	fout << "}, \"allocations\": {";
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++)
+	{
+		if(i >= 1) fout << ", ";
+		fout << "\"" << profile_stage_names[i] << "\": " << allocations[i];
+	}
+	fout << "}}";
+	return 0;
+}
+
+int profiler::add(const bundle_profile &p)
+{
+	bundles.push_back(p);
+	return 0;
+}
+
+int profiler::write(const string &file) const
+{
+	// JSON if the file name ends with .json, otherwise TSV
+	ofstream fout(file.c_str(), fstream::trunc);
+	if(fout.fail())
+	{
+		printf("failed to open %s\n", file.c_str());
+		return 0;
+	}
+
+	bool json = file.size() >= 5 && file.compare(file.size() - 5, 5, ".json") == 0;
+	if(json == true)
+	{
+		fout << "{\"bundles\": [\n";
+		for(int i = 0; i < bundles.size(); i++)
+		{
+			fout << "  ";
+			bundles[i].write_json(fout);
+			fout << (i + 1 < bundles.size() ? ",\n" : "\n");
+		}
+		fout << "]}\n";
+	}
+	else
+	{
+		bundle_profile::write_tsv_header(fout);
+		for(int i = 0; i < bundles.size(); i++) bundles[i].write_tsv(fout);
+	}
+
+	fout.close();
+	return 0;
+}
+
+int profiler::print_top(int n) const
+{
+	vector< pair<double, int> > v(bundles.size());
+	for(int i = 0; i < bundles.size(); i++) v[i] = pair<double, int>(0 - bundles[i].seconds[PROFILE_TOTAL], i);
+	sort(v.begin(), v.end());
+	if(n > v.size()) n = v.size();
+
+	// total time and allocations of each stage over all bundles
+	double sum[NUM_PROFILE_STAGES];
+	uint64_t allocs[NUM_PROFILE_STAGES];
+	for(int k = 0; k < NUM_PROFILE_STAGES; k++) sum[k] = 0;
+	for(int k = 0; k < NUM_PROFILE_STAGES; k++) allocs[k] = 0;
+	for(int i = 0; i < bundles.size(); i++)
+	{
+		for(int k = 0; k < NUM_PROFILE_STAGES; k++) sum[k] += bundles[i].seconds[k];
+		for(int k = 0; k < NUM_PROFILE_STAGES; k++) allocs[k] += bundles[i].allocations[k];
+	}
+
+	printf("profile of %lu bundles, seconds and allocations per stage:\n", bundles.size());
+	for(int k = 0; k < NUM_PROFILE_STAGES; k++) printf("  %-26s %.3lf %lu\n", profile_stage_names[k], sum[k], (unsigned long)allocs[k]);
+
+	printf("top %d slowest bundles:\n", n);
+	for(int j = 0; j < n; j++)
+	{
+		const bundle_profile &p = bundles[v[j].second];
+		int s = 0;
+		for(int k = 1; k < PROFILE_TOTAL; k++) if(p.seconds[k] > p.seconds[s]) s = k;
+		printf("  %s:%d-%d %c, %.3lf seconds, hits = %d, fragments = %d, circ_fragments = %d, slowest stage = %s (%.3lf)\n",
+				p.chrm.c_str(), p.lpos, p.rpos, p.strand, p.seconds[PROFILE_TOTAL], p.hits, p.fragments, p.circ_fragments,
+				profile_stage_names[s], p.seconds[s]);
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <chrono>
+
+using namespace std;
+
+// stages of bundle_bridge::build that are timed separately
+enum
+{
+	PROFILE_SUPPLEMENTARIES = 0,
+	PROFILE_JUNCTIONS,
+	PROFILE_REGIONS,
+	PROFILE_FRAGMENTS,
+	PROFILE_CIRC_FRAGMENTS,
+	PROFILE_MORE_CHIMERIC,
+	PROFILE_FAKE_FRAGMENTS,
+	PROFILE_BRIDGE_NORMAL,
+	PROFILE_BRIDGE_CIRC,
+	PROFILE_JOIN_PAIRS,
+	PROFILE_TOTAL,
+	NUM_PROFILE_STAGES
+};
+
+extern const char *profile_stage_names[NUM_PROFILE_STAGES];
+
+// allocations through operator new, counted only while count_allocations is set
+extern bool count_allocations;
+uint64_t get_num_allocations();
+
+// per-stage timers and counters of one bundle
+class bundle_profile
+{
+public:
+	bundle_profile();
+
+public:
+	string chrm;						// chromosome of the bundle
+	int32_t lpos;						// left boundary of the bundle
+	int32_t rpos;						// right boundary of the bundle
+	char strand;						// strand of the bundle
+	int hits;							// number of hits
+	int junctions;						// number of splice junctions
+	int regions;						// number of regions
+	int fragments;						// number of fragments
+	int circ_fragments;					// number of circ fragments
+	int64_t path_nodes;					// number of path nodes built by the bridger
+	int64_t dp_cells;					// number of entries created by bridging DP
+	double seconds[NUM_PROFILE_STAGES];	// wall time of each stage
+	uint64_t allocations[NUM_PROFILE_STAGES];	// allocations of each stage, if count_allocations
+
+public:
+	int write_tsv(ostream &fout) const;
+	int write_json(ostream &fout) const;
+	static int write_tsv_header(ostream &fout);
+};
+
+// adds the time spent in its scope to one stage; does nothing for a NULL profile
+class stage_timer
+{
+public:
+	stage_timer(bundle_profile *p, int s)
+		: prof(p), stage(s)
+	{
+		if(prof == NULL) return;
+		t0 = chrono::steady_clock::now();
+		a0 = get_num_allocations();
+	}
+
+	~stage_timer()
+	{
+		if(prof == NULL) return;
+		prof->seconds[stage] += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+		prof->allocations[stage] += get_num_allocations() - a0;
+	}
+
+private:
+	bundle_profile *prof;
+	int stage;
+	chrono::steady_clock::time_point t0;
+	uint64_t a0;
+};
+
+// profiles of all bundles of a run
+class profiler
+{
+public:
+	vector<bundle_profile> bundles;
+
+public:
+	int add(const bundle_profile &p);
+	int write(const string &file) const;
+	int print_top(int n) const;
+};
+
+#endif
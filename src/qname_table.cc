@@ -0,0 +1,140 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include "qname_table.h"
+
+qname_table::qname_table()
+{
+}
+
+int qname_table::clear()
+{
+	slots.clear();
+	qhashes.clear();
+	qnames.clear();
+	return 0;
+}
+
+int qname_table::reserve(int n)
+{
+	if(n * 2 > (int)slots.size()) rehash(n * 2);
+	qhashes.reserve(n);
+	qnames.reserve(n);
+	return 0;
+}
+
+int qname_table::rehash(int n)
+{
+	// table size is a power of 2, at least n
+	size_t m = 16;
+	while(m < n) m = m << 1;
+
+	slots.assign(m, -1);
+	for(int i = 0; i < qhashes.size(); i++)
+	{
+		size_t k = qhashes[i] & (m - 1);
+		while(slots[k] != -1) k = (k + 1) & (m - 1);
+		slots[k] = i;
+	}
+	return 0;
+}
+
+int qname_table::find(size_t qhash, const string &qname) const
+{
+	if(slots.size() == 0) return -1;
+	size_t m = slots.size();
+	size_t k = qhash & (m - 1);
+	while(slots[k] != -1)
+	{
+		int x = slots[k];
+		if(qhashes[x] == qhash && *qnames[x] == qname) return x;
+		k = (k + 1) & (m - 1);
+	}
+	return -1;
+}
+
+int qname_table::intern(const hit &h)
+{
+	// keep the load factor below 1/2
+	if((qhashes.size() + 1) * 2 > slots.size()) rehash((qhashes.size() + 1) * 2);
+
+	size_t m = slots.size();
+	size_t k = h.qhash & (m - 1);
+	while(slots[k] != -1)
+	{
+		int x = slots[k];
+		if(qhashes[x] == h.qhash && *qnames[x] == h.qname) return x;
+		k = (k + 1) & (m - 1);
+	}
+
+	int x = qhashes.size();
+	slots[k] = x;
+	qhashes.push_back(h.qhash);
+	qnames.push_back(&h.qname);
+	return x;
+}
+
+int qname_table::size() const
+{
+	return qhashes.size();
+}
+
+qname_pool::qname_pool()
+{
+}
+
+int qname_pool::clear()
+{
+	slots.clear();
+	qhashes.clear();
+	qnames.clear();
+	return 0;
+}
+
+int qname_pool::rehash(int n)
+{
+	size_t m = 16;
+	while(m < n) m = m << 1;
+
+	slots.assign(m, -1);
+	for(int i = 0; i < qhashes.size(); i++)
+	{
+		size_t k = qhashes[i] & (m - 1);
+		while(slots[k] != -1) k = (k + 1) & (m - 1);
+		slots[k] = i;
+	}
+	return 0;
+}
+
+int qname_pool::intern(size_t qhash, const string &qname)
+{
+	// keep the load factor below 1/2
+	if((qhashes.size() + 1) * 2 > slots.size()) rehash((qhashes.size() + 1) * 2);
+
+	size_t m = slots.size();
+	size_t k = qhash & (m - 1);
+	while(slots[k] != -1)
+	{
+		int x = slots[k];
+		if(qhashes[x] == qhash && qnames[x] == qname) return x;
+		k = (k + 1) & (m - 1);
+	}
+
+	int x = qhashes.size();
+	slots[k] = x;
+	qhashes.push_back(qhash);
+	qnames.push_back(qname);
+	return x;
+}
+
+const string& qname_pool::get(int x) const
+{
+	return qnames[x];
+}
+
+int qname_pool::size() const
+{
+	return qhashes.size();
+}
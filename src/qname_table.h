@@ -0,0 +1,60 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __QNAME_TABLE_H__
+#define __QNAME_TABLE_H__
+
+#include <string>
+#include <vector>
+
+#include "hit.h"
+
+using namespace std;
+
+// per-bundle interning of read names: each distinct qname gets a dense id
+class qname_table
+{
+public:
+	qname_table();
+
+public:
+	vector<int> slots;					// open-addressing slots holding ids, -1 if empty
+	vector<size_t> qhashes;				// hash code of each id
+	vector<const string*> qnames;		// name of each id, owned by the hits
+
+public:
+	int clear();
+	int reserve(int n);
+	int intern(const hit &h);
+	int find(size_t qhash, const string &qname) const;
+	int size() const;
+
+private:
+	int rehash(int n);
+};
+
+// run-wide interning of read names that owns the strings,
+// so that ids stay valid after the bundles are released
+class qname_pool
+{
+public:
+	qname_pool();
+
+public:
+	vector<int> slots;					// open-addressing slots holding ids, -1 if empty
+	vector<size_t> qhashes;				// hash code of each id
+	vector<string> qnames;				// name of each id
+
+public:
+	int clear();
+	int intern(size_t qhash, const string &qname);
+	const string& get(int x) const;
+	int size() const;
+
+private:
+	int rehash(int n);
+};
+
+#endif
@@ -22,38 +22,36 @@ int reference::build_interval_set_map()
 		if(c == '-') add_interval_set(isms2, k);
 	}
 
+	index_interval_set(isms0);
+	index_interval_set(isms1);
+	index_interval_set(isms2);
+
 	// printf("isms0 size: %lu\n",isms0.size());
 	// printf("isms1 size: %lu\n",isms1.size());
 	// printf("isms2 size: %lu\n",isms2.size());
 	return 0;
 }
 
-int reference::add_interval_set(map<string, interval_set_map> &isms, int k)
+int reference::add_interval_set(map<string, interval_index> &isms, int k)
 {
 	if(genes[k].transcripts.size() <= 0) return 0;
 
 	PI32 p = genes[k].get_bounds();
 
 	if(p.first >= p.second) return 0;
-	interval32 x(p.first, p.second);
-
-	set<int> s;
-	s.insert(k);
 
 	string chrm = genes[k].get_seqname();
 	//printf("shao: add gene %d-%d to chrm %s, gene-id = %s, strand = %c\n", p.first, p.second, chrm.c_str(), genes[k].get_gene_id().c_str(), genes[k].get_strand());
 
-	if(isms.find(chrm) == isms.end())
-	{
-		interval_set_map ism;
-		ism += make_pair(x, s);
-		isms.insert(pair<string, interval_set_map>(chrm, ism));
-		//printf("add_interval_set if cond\n");
-	}
-	else
+	isms[chrm].add(p.first, p.second, k);
+	return 0;
+}
+
+int reference::index_interval_set(map<string, interval_index> &isms)
+{
+	for(map<string, interval_index>::iterator it = isms.begin(); it != isms.end(); it++)
 	{
-		isms[chrm] += make_pair(x, s);
-		//printf("add_interval_set else cond\n");
+		it->second.index();
 	}
 	return 0;
 }
@@ -76,17 +74,19 @@ vector<transcript> reference::get_overlapped_transcripts(string chrm, char c, in
 	return v;
 }
 
-vector<transcript> reference::get_overlapped_transcripts(const map<string, interval_set_map> &isms, string chrm, int32_t x, int32_t y) const
+vector<transcript> reference::get_overlapped_transcripts(const map<string, interval_index> &isms, string chrm, int32_t x, int32_t y) const
 {
 	vector<transcript> v;
-	map<string, interval_set_map>::const_iterator it = isms.find(chrm);
+	map<string, interval_index>::const_iterator it = isms.find(chrm);
 	if(it == isms.end()) return v;
-	set<int> s = get_overlapped_set(it->second, x, y);
+
+	vector<int> s;
+	it->second.overlap(x, y, s);
 
 	//printf("shao: query %d-%d of chrm %s and found %lu genes\n", x, y, chrm.c_str(), s.size());
-	for(set<int>::iterator x = s.begin(); x != s.end(); x++)
+	for(int k = 0; k < s.size(); k++)
 	{
-		v.insert(v.end(), genes[*x].transcripts.begin(), genes[*x].transcripts.end());
+		v.insert(v.end(), genes[s[k]].transcripts.begin(), genes[s[k]].transcripts.end());
 	}
 	return v;
 }
@@ -98,20 +98,20 @@ int reference::print()
 	{
 		printf("gene %d with %lu transcripts\n", i, genes[i].transcripts.size());
 	}
-	for(map<string, interval_set_map>::iterator it = isms0.begin(); it != isms0.end(); it++)
+	for(map<string, interval_index>::iterator it = isms0.begin(); it != isms0.end(); it++)
 	{
 		printf("chromosomes %s with strand = .\n", it->first.c_str());
-		print_interval_set_map(it->second);
+		it->second.print();
 	}
-	for(map<string, interval_set_map>::iterator it = isms1.begin(); it != isms1.end(); it++)
+	for(map<string, interval_index>::iterator it = isms1.begin(); it != isms1.end(); it++)
 	{
 		printf("chromosomes %s with strand = +\n", it->first.c_str());
-		print_interval_set_map(it->second);
+		it->second.print();
 	}
-	for(map<string, interval_set_map>::iterator it = isms2.begin(); it != isms2.end(); it++)
+	for(map<string, interval_index>::iterator it = isms2.begin(); it != isms2.end(); it++)
 	{
 		printf("chromosomes %s with strand = -\n", it->first.c_str());
-		print_interval_set_map(it->second);
+		it->second.print();
 	}
 	return 0;
 }
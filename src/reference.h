@@ -10,7 +10,7 @@ See LICENSE for licensing.
 #include <map>
 
 #include "genome.h"
-#include "interval_map.h"
+#include "interval_index.h"
 
 using namespace std;
 
@@ -20,16 +20,17 @@ public:
 	reference(const string &file);
 
 public:
-	map<string, interval_set_map> isms0;		// indexed by chrm name
-	map<string, interval_set_map> isms1;		// indexed by chrm name
-	map<string, interval_set_map> isms2;		// indexed by chrm name
+	map<string, interval_index> isms0;			// gene intervals with strand ., indexed by chrm name
+	map<string, interval_index> isms1;			// gene intervals with strand +, indexed by chrm name
+	map<string, interval_index> isms2;			// gene intervals with strand -, indexed by chrm name
 
 public:
 	int build_interval_set_map();
-	int add_interval_set(map<string, interval_set_map> &isms, int k);
+	int add_interval_set(map<string, interval_index> &isms, int k);
+	int index_interval_set(map<string, interval_index> &isms);
 	int print();
 	vector<transcript> get_overlapped_transcripts(string chrm, char c, int32_t x, int32_t y) const;
-	vector<transcript> get_overlapped_transcripts(const map<string, interval_set_map> &isms, string chrm, int32_t x, int32_t y) const;
+	vector<transcript> get_overlapped_transcripts(const map<string, interval_index> &isms, string chrm, int32_t x, int32_t y) const;
 };
 
 #endif
@@ -51,4 +51,18 @@ private:
 	int build_partial_exons();
 };
 
+// extent of a region without its interval maps and partial exons,
+// for paths and circRNAs that only need the coordinates
+class region_span
+{
+public:
+	region_span(int32_t _lpos, int32_t _rpos) : lpos(_lpos), rpos(_rpos), gapped(false) {}
+	region_span(const region &r) : lpos(r.lpos), rpos(r.rpos), gapped(r.gapped) {}
+
+public:
+	int32_t lpos;					// the leftmost boundary on reference
+	int32_t rpos;					// the rightmost boundary on reference
+	bool gapped;					// copied from the region
+};
+
 #endif
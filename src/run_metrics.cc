@@ -0,0 +1,130 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <sys/resource.h>
+
+#include "run_metrics.h"
+
+bool count_allocations = false;
+static atomic<uint64_t> num_allocations(0);
+
+// counting replacement of the global allocation functions; new[] and the
+// nothrow forms of libstdc++ forward to this one
+void* operator new(size_t n)
+{
+	if(count_allocations == true) num_allocations.fetch_add(1, memory_order_relaxed);
+	void *p = malloc(n == 0 ? 1 : n);
+	if(p == NULL) throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+uint64_t get_num_allocations()
+{
+	return num_allocations.load(memory_order_relaxed);
+}
+
+long get_peak_rss_kb()
+{
+	struct rusage ru;
+	if(getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+	return ru.ru_maxrss / 1024;		// bytes on macOS
+#else
+	return ru.ru_maxrss;
+#endif
+}
+
+string json_escape(const string &s)
+{
+	string t;
+	for(int i = 0; i < s.size(); i++)
+	{
+		char c = s[i];
+		if(c == '"' || c == '\\')
+		{
+			t.push_back('\\');
+			t.push_back(c);
+		}
+		else if((unsigned char)c < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+			t.append(buf);
+		}
+		else t.push_back(c);
+	}
+	return t;
+}
+
+run_metrics::run_metrics()
+{
+	t0 = chrono::steady_clock::now();
+	t1 = t0;
+	t2 = t0;
+	last_write = t0;
+	preview_seconds = 0;
+	postprocessing = false;
+	done = false;
+	num_bundles = 0;
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++)
+	{
+		stage_seconds[i] = 0;
+		stage_allocations[i] = 0;
+	}
+}
+
+int run_metrics::add(const bundle_profile &p)
+{
+	num_bundles++;
+	for(int i = 0; i < NUM_PROFILE_STAGES; i++)
+	{
+		stage_seconds[i] += p.seconds[i];
+		stage_allocations[i] += p.allocations[i];
+	}
+	return 0;
+}
+
+int run_metrics::start_postprocessing()
+{
+	t1 = chrono::steady_clock::now();
+	postprocessing = true;
+	return 0;
+}
+
+int run_metrics::finish()
+{
+	if(postprocessing == false) start_postprocessing();
+	t2 = chrono::steady_clock::now();
+	done = true;
+	return 0;
+}
+
+double run_metrics::assembly_seconds() const
+{
+	chrono::steady_clock::time_point t = (postprocessing == true) ? t1 : chrono::steady_clock::now();
+	return chrono::duration<double>(t - t0).count();
+}
+
+double run_metrics::postprocessing_seconds() const
+{
+	if(postprocessing == false) return 0;
+	chrono::steady_clock::time_point t = (done == true) ? t2 : chrono::steady_clock::now();
+	return chrono::duration<double>(t - t1).count();
+}
+
+bool run_metrics::due(double interval) const
+{
+	if(interval <= 0) return false;
+	return chrono::duration<double>(chrono::steady_clock::now() - last_write).count() >= interval;
+}
@@ -0,0 +1,50 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __RUN_METRICS_H__
+#define __RUN_METRICS_H__
+
+#include <stdint.h>
+#include <string>
+#include <chrono>
+
+#include "profiler.h"
+
+using namespace std;
+
+// peak resident set size of this process in KB
+long get_peak_rss_kb();
+
+// escape a string for a JSON string literal
+string json_escape(const string &s);
+
+// run-wide timing and per-stage totals reported by --metrics
+class run_metrics
+{
+public:
+	run_metrics();
+
+public:
+	chrono::steady_clock::time_point t0;				// start of assembly
+	chrono::steady_clock::time_point t1;				// start of post-processing
+	chrono::steady_clock::time_point t2;				// end of post-processing
+	chrono::steady_clock::time_point last_write;		// last time the report was written
+	double preview_seconds;								// time spent in preview
+	bool postprocessing;								// whether post-processing has started
+	bool done;											// whether post-processing has finished
+	int num_bundles;									// number of bundles assembled
+	double stage_seconds[NUM_PROFILE_STAGES];			// time of each stage over all bundles
+	uint64_t stage_allocations[NUM_PROFILE_STAGES];		// allocations of each stage over all bundles
+
+public:
+	int add(const bundle_profile &p);
+	int start_postprocessing();
+	int finish();
+	double assembly_seconds() const;
+	double postprocessing_seconds() const;
+	bool due(double interval) const;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#ifndef __SMALL_VECTOR_H__
+#define __SMALL_VECTOR_H__
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <vector>
+#include <new>
+
+using namespace std;
+
+// vector of trivially copyable elements that stores up to N elements
+// inline and spills to the heap beyond that; iterators are plain pointers
+template<typename T, int N>
+class small_vector
+{
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef size_t size_type;
+
+public:
+	small_vector() : p(buf), n(0), cap(N) {}
+	small_vector(const small_vector &x) : p(buf), n(0), cap(N) { assign(x.begin(), x.end()); }
+	small_vector(const vector<T> &x) : p(buf), n(0), cap(N) { assign(x.begin(), x.end()); }
+	template<typename I> small_vector(I first, I last) : p(buf), n(0), cap(N) { assign(first, last); }
+	~small_vector() { if(p != buf) free(p); }
+
+	small_vector& operator=(const small_vector &x) { if(this != &x) assign(x.begin(), x.end()); return *this; }
+	small_vector& operator=(const vector<T> &x) { assign(x.begin(), x.end()); return *this; }
+	explicit operator vector<T>() const { return vector<T>(begin(), end()); }
+
+private:
+	T *p;			// points to buf while inline
+	uint32_t n;		// number of elements
+	uint32_t cap;	// capacity
+	T buf[N];		// inline storage
+
+public:
+	size_t size() const { return n; }
+	size_t capacity() const { return cap; }
+	bool empty() const { return n == 0; }
+	bool is_inline() const { return p == buf; }
+
+	T* data() { return p; }
+	const T* data() const { return p; }
+	iterator begin() { return p; }
+	iterator end() { return p + n; }
+	const_iterator begin() const { return p; }
+	const_iterator end() const { return p + n; }
+
+	T& operator[](size_t i) { return p[i]; }
+	const T& operator[](size_t i) const { return p[i]; }
+	T& front() { return p[0]; }
+	const T& front() const { return p[0]; }
+	T& back() { return p[n - 1]; }
+	const T& back() const { return p[n - 1]; }
+
+	void reserve(size_t c)
+	{
+		if(c <= cap) return;
+		if(c < 2 * (size_t)cap) c = 2 * cap;
+		T *q = (T*)malloc(c * sizeof(T));
+		if(q == NULL) throw bad_alloc();
+		if(n > 0) memcpy((void*)q, (const void*)p, n * sizeof(T));
+		if(p != buf) free(p);
+		p = q;
+		cap = c;
+	}
+
+	void clear() { n = 0; }
+	void push_back(const T &x) { if(n == cap) { T y = x; reserve(n + 1); p[n++] = y; } else p[n++] = x; }
+	void pop_back() { assert(n >= 1); n--; }
+	void resize(size_t m) { reserve(m); for(size_t i = n; i < m; i++) p[i] = T(); n = m; }
+	void resize(size_t m, const T &x) { reserve(m); for(size_t i = n; i < m; i++) p[i] = x; n = m; }
+
+	template<typename I> void assign(I first, I last)
+	{
+		n = 0;
+		reserve(last - first);
+		for(; first != last; first++) p[n++] = *first;
+	}
+
+	iterator insert(iterator pos, const T &x)
+	{
+		T y = x;
+		size_t k = pos - p;
+		reserve(n + 1);
+		memmove((void*)(p + k + 1), (const void*)(p + k), (n - k) * sizeof(T));
+		p[k] = y;
+		n++;
+		return p + k;
+	}
+
+	template<typename I> iterator insert(iterator pos, I first, I last)
+	{
+		// the inserted range must not alias this container
+		size_t k = pos - p;
+		size_t m = last - first;
+		reserve(n + m);
+		memmove((void*)(p + k + m), (const void*)(p + k), (n - k) * sizeof(T));
+		for(size_t i = 0; i < m; i++, first++) p[k + i] = *first;
+		n += m;
+		return p + k;
+	}
+
+	iterator erase(iterator pos) { return erase(pos, pos + 1); }
+	iterator erase(iterator first, iterator last)
+	{
+		memmove((void*)first, (const void*)last, (end() - last) * sizeof(T));
+		n -= last - first;
+		return first;
+	}
+
+	bool operator==(const small_vector &x) const { return equal_to(x.begin(), x.size()); }
+	bool operator!=(const small_vector &x) const { return !equal_to(x.begin(), x.size()); }
+	bool operator==(const vector<T> &x) const { return equal_to(x.data(), x.size()); }
+	bool operator!=(const vector<T> &x) const { return !equal_to(x.data(), x.size()); }
+
+private:
+	bool equal_to(const T *q, size_t m) const
+	{
+		if(m != n) return false;
+		for(size_t i = 0; i < n; i++) if(!(p[i] == q[i])) return false;
+		return true;
+	}
+};
+
+#endif
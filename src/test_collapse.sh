@@ -0,0 +1,20 @@
+#!/bin/sh
+# assemble the same reads with and without collapsing duplicate fragments;
+# test_collapse.sam has PCR duplicates of circ fragments whose hits are
+# shared with normal fragments, and both runs must give identical output
+
+srcdir=${srcdir:-.}
+tmp=${TMPDIR:-/tmp}/test_collapse.$$
+opts="--read_length 100 --library_type unstranded --insertsize_median 230 --insertsize_low 150 --insertsize_high 400"
+
+for f in true false
+do
+	./terrace -i $srcdir/test_collapse.sam -o $tmp.$f.gtf -fe $tmp.$f.fe $opts --collapse_duplicate_fragments $f > /dev/null || exit 1
+done
+
+r=0
+cmp -s $tmp.true.gtf $tmp.false.gtf || r=1
+cmp -s $tmp.true.fe $tmp.false.fe || r=1
+test -s $tmp.true.gtf || r=1
+rm -f $tmp.true.gtf $tmp.false.gtf $tmp.true.fe $tmp.false.fe
+exit $r
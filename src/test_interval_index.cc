@@ -0,0 +1,74 @@
+/*
+(c) 2023 by Tasfia Zahin, Mingfu Shao, and The Pennsylvania State University.
+See LICENSE for licensing.
+*/
+
+#include "interval_index.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// brute-force check of interval_index::overlap against a linear scan,
+// for array sizes around and between powers of two
+int check(int n, int num_queries, int32_t span)
+{
+	interval_index ii;
+	vector<interval_record> v;
+	for(int i = 0; i < n; i++)
+	{
+		int32_t l = rand() % span;
+		int32_t r = l + 1 + rand() % (rand() % 8 == 0 ? span + 1 : 50);
+		ii.add(l, r, i);
+		interval_record x;
+		x.lpos = l;
+		x.rpos = r;
+		x.value = i;
+		v.push_back(x);
+	}
+	ii.index();
+
+	int fails = 0;
+	for(int q = 0; q < num_queries; q++)
+	{
+		// half of the queries fall near the tail, where the implicit tree is incomplete
+		int32_t x = rand() % (span + 100) - 50;
+		if(q % 2 == 1) x = span - 1 - rand() % (span / 8 + 1);
+		int32_t y = x + 1 + rand() % 200;
+
+		vector<int> a;
+		ii.overlap(x, y, a);
+
+		vector<int> b;
+		for(int i = 0; i < v.size(); i++)
+		{
+			if(v[i].lpos < y && v[i].rpos > x) b.push_back(v[i].value);
+		}
+		sort(b.begin(), b.end());
+
+		if(a != b) fails++;
+	}
+
+	if(fails > 0) printf("interval_index: n = %d, %d / %d queries mismatch\n", n, fails, num_queries);
+	return fails;
+}
+
+int main()
+{
+	srand(20230419);
+
+	int fails = 0;
+	for(int n = 0; n <= 1000; n++) fails += check(n, 200, n * 4 + 10);
+	for(int k = 9; k <= 16; k++)
+	{
+		int p = 1 << k;
+		fails += check(p - 1, 500, p * 4);
+		fails += check(p, 500, p * 4);
+		fails += check(p + 1, 500, p * 4);
+		fails += check(p + rand() % p, 500, p * 4);
+	}
+
+	if(fails > 0) return 1;
+	printf("interval_index: all queries agree with linear scan\n");
+	return 0;
+}
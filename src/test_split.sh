@@ -0,0 +1,24 @@
+#!/bin/sh
+# assemble the same reads with and without splitting bundles on coverage
+# gaps; in test_split.sam the two exons of a circRNA are separate bundles,
+# and back-spliced reads and their mates are cut apart, so the receiving
+# bundle needs the whole read group and the junctions around it; both
+# runs must report the same circRNAs (bundle_size, the 2nd feature
+# column, counts fragments of the bundle and may differ)
+
+srcdir=${srcdir:-.}
+tmp=${TMPDIR:-/tmp}/test_split.$$
+opts="-r $srcdir/test_split.gtf --read_length 100 --library_type unstranded --insertsize_median 230 --insertsize_low 150 --insertsize_high 400"
+
+for f in true false
+do
+	./terrace -i $srcdir/test_split.sam -o $tmp.$f.gtf -fe $tmp.$f.fe $opts --split_bundles $f > /dev/null || exit 1
+	cut -d, -f1,3- $tmp.$f.fe > $tmp.$f.fx
+done
+
+r=0
+cmp -s $tmp.true.gtf $tmp.false.gtf || r=1
+cmp -s $tmp.true.fx $tmp.false.fx || r=1
+test -s $tmp.true.gtf || r=1
+rm -f $tmp.true.gtf $tmp.false.gtf $tmp.true.fe $tmp.false.fe $tmp.true.fx $tmp.false.fx
+exit $r